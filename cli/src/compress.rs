@@ -0,0 +1,192 @@
+use anyhow::{bail, Context, Result};
+use colored::Colorize;
+use std::fs;
+use std::path::{Path, PathBuf};
+
+// LZSS parameters shared with the firmware decompressor in
+// components/ice40/fpga_loader.c. Container layout:
+//   - 4-byte magic "AFLZ"
+//   - u32 LE decompressed size
+//   - token stream: flag byte consumed MSB-first, 1 = literal byte,
+//     0 = 16-bit big-endian back-reference (12-bit distance-1, 4-bit length-3)
+const MAGIC: &[u8; 4] = b"AFLZ";
+const WINDOW_SIZE: usize = 4096;
+const MIN_MATCH: usize = 3;
+const MAX_MATCH: usize = 18;
+const MAX_CHAIN: usize = 128;
+
+/// Compress a bitstream into the AFLZ container understood by
+/// fpga_loader_load_from_rom() and friends.
+pub fn compress_bitstream(input: &str, output: Option<&str>) -> Result<()> {
+    let input = Path::new(input);
+    let data = fs::read(input).with_context(|| format!("Failed to read {}", input.display()))?;
+
+    if data.len() >= 4 && data[..4] == MAGIC[..] {
+        bail!("{} is already AFLZ-compressed", input.display());
+    }
+
+    let compressed = compress(&data);
+
+    // Paranoia: round-trip before writing anything the loader will trust
+    let check = decompress(&compressed)?;
+    if check != data {
+        bail!("Internal error: round-trip verification failed");
+    }
+
+    let out_path: PathBuf = match output {
+        Some(path) => PathBuf::from(path),
+        None => {
+            let mut ext = input
+                .extension()
+                .map(|e| e.to_string_lossy().into_owned())
+                .unwrap_or_default();
+            ext.push('z');
+            input.with_extension(ext)
+        }
+    };
+    fs::write(&out_path, &compressed)
+        .with_context(|| format!("Failed to write {}", out_path.display()))?;
+
+    println!(
+        "{}",
+        format!(
+            "==> {} ({} bytes) -> {} ({} bytes, {:.1}% of original)",
+            input.display(),
+            data.len(),
+            out_path.display(),
+            compressed.len(),
+            compressed.len() as f64 * 100.0 / data.len().max(1) as f64,
+        )
+        .blue()
+        .bold()
+    );
+
+    Ok(())
+}
+
+fn hash3(data: &[u8], pos: usize) -> usize {
+    let h = (data[pos] as u32) << 16 | (data[pos + 1] as u32) << 8 | data[pos + 2] as u32;
+    (h.wrapping_mul(2654435761) >> 20) as usize & 0xFFF
+}
+
+fn compress(data: &[u8]) -> Vec<u8> {
+    let mut out = Vec::with_capacity(data.len() / 2 + 16);
+    out.extend_from_slice(MAGIC);
+    out.extend_from_slice(&(data.len() as u32).to_le_bytes());
+
+    // Hash chains over 3-byte prefixes for match finding
+    let mut head = vec![usize::MAX; 4096];
+    let mut prev = vec![usize::MAX; data.len()];
+
+    let mut flag_index: Option<usize> = None;
+    let mut flag_bits = 0u32;
+
+    let insert = |head: &mut Vec<usize>, prev: &mut Vec<usize>, pos: usize| {
+        if pos + MIN_MATCH <= data.len() {
+            let h = hash3(data, pos);
+            prev[pos] = head[h];
+            head[h] = pos;
+        }
+    };
+
+    let mut pos = 0;
+    while pos < data.len() {
+        // Find the longest match in the window via the hash chain
+        let mut best_len = 0;
+        let mut best_dist = 0;
+        if pos + MIN_MATCH <= data.len() {
+            let max_len = MAX_MATCH.min(data.len() - pos);
+            let mut candidate = head[hash3(data, pos)];
+            let mut chain = 0;
+            while candidate != usize::MAX && chain < MAX_CHAIN {
+                let dist = pos - candidate;
+                if dist > WINDOW_SIZE {
+                    break;
+                }
+                let len = data[candidate..]
+                    .iter()
+                    .zip(&data[pos..pos + max_len])
+                    .take_while(|(a, b)| a == b)
+                    .count();
+                if len > best_len {
+                    best_len = len;
+                    best_dist = dist;
+                    if len == max_len {
+                        break;
+                    }
+                }
+                candidate = prev[candidate];
+                chain += 1;
+            }
+        }
+
+        // Start a new flag byte every 8 tokens
+        if flag_bits == 0 {
+            flag_index = Some(out.len());
+            out.push(0);
+            flag_bits = 8;
+        }
+        let flag_index = flag_index.unwrap();
+        flag_bits -= 1;
+
+        if best_len >= MIN_MATCH {
+            let token = ((best_dist - 1) as u16) << 4 | (best_len - MIN_MATCH) as u16;
+            out.extend_from_slice(&token.to_be_bytes());
+            for i in 0..best_len {
+                insert(&mut head, &mut prev, pos + i);
+            }
+            pos += best_len;
+        } else {
+            out[flag_index] |= 0x80 >> (7 - flag_bits);
+            out.push(data[pos]);
+            insert(&mut head, &mut prev, pos);
+            pos += 1;
+        }
+    }
+
+    out
+}
+
+fn decompress(data: &[u8]) -> Result<Vec<u8>> {
+    if data.len() < 8 || data[..4] != MAGIC[..] {
+        bail!("Not an AFLZ container");
+    }
+    let raw_size = u32::from_le_bytes(data[4..8].try_into().unwrap()) as usize;
+
+    let mut out = Vec::with_capacity(raw_size);
+    let mut pos = 8;
+    let mut flags = 0u8;
+    let mut flag_bits = 0;
+
+    while out.len() < raw_size {
+        if flag_bits == 0 {
+            flags = *data.get(pos).context("Truncated stream")?;
+            pos += 1;
+            flag_bits = 8;
+        }
+        let literal = flags & 0x80 != 0;
+        flags <<= 1;
+        flag_bits -= 1;
+
+        if literal {
+            out.push(*data.get(pos).context("Truncated stream")?);
+            pos += 1;
+        } else {
+            if pos + 2 > data.len() {
+                bail!("Truncated stream");
+            }
+            let token = u16::from_be_bytes([data[pos], data[pos + 1]]);
+            pos += 2;
+            let dist = (token >> 4) as usize + 1;
+            let len = (token & 0xF) as usize + MIN_MATCH;
+            if dist > out.len() {
+                bail!("Back-reference before start of stream");
+            }
+            for _ in 0..len {
+                out.push(out[out.len() - dist]);
+            }
+        }
+    }
+
+    Ok(out)
+}
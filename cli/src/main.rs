@@ -3,9 +3,11 @@ use clap::{Parser, Subcommand};
 use colored::Colorize;
 
 mod build;
+mod compress;
 mod config;
 mod demo;
 mod docker;
+mod pack;
 mod project;
 mod test;
 mod watch;
@@ -109,6 +111,30 @@ enum Commands {
         parallel: bool,
     },
 
+    /// Compress a bitstream for the firmware's streaming decompressor
+    Compress {
+        /// Input bitstream (e.g. fpga/top.bin)
+        input: String,
+
+        /// Output file (default: input with 'z' appended to the extension)
+        #[arg(short, long)]
+        output: Option<String>,
+    },
+
+    /// Wrap a bitstream in the AFBS container (length, CRC32, device ID)
+    Pack {
+        /// Input bitstream, bare or AFLZ-compressed
+        input: String,
+
+        /// Output file (default: input with '.img' appended)
+        #[arg(short, long)]
+        output: Option<String>,
+
+        /// Target device identity (0 = any)
+        #[arg(short, long, default_value_t = 0)]
+        device_id: u16,
+    },
+
     /// Lint Verilog files
     Lint {
         /// FPGA directory (default: fpga)
@@ -180,6 +206,19 @@ enum DockerCommands {
 fn main() -> Result<()> {
     let cli = Cli::parse();
 
+    // Pure host-side commands that don't need Docker or a project
+    if let Commands::Compress { input, output } = &cli.command {
+        return compress::compress_bitstream(input, output.as_deref());
+    }
+    if let Commands::Pack {
+        input,
+        output,
+        device_id,
+    } = &cli.command
+    {
+        return pack::pack_bitstream(input, output.as_deref(), *device_id);
+    }
+
     let docker = Docker::new(cli.image, cli.verbose)?;
     let project = Project::detect()?;
 
@@ -270,6 +309,9 @@ fn main() -> Result<()> {
             )?;
         }
 
+        // Handled before Docker detection above
+        Commands::Compress { .. } | Commands::Pack { .. } => unreachable!(),
+
         Commands::Lint { dir } => {
             project.require_project()?;
             docker.ensure_image()?;
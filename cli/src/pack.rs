@@ -0,0 +1,77 @@
+use anyhow::{bail, Context, Result};
+use colored::Colorize;
+use std::fs;
+use std::path::{Path, PathBuf};
+
+// Container layout shared with components/ice40/include/ice40/fpga_image.h:
+//   - 4-byte magic "AFBS"
+//   - u32 LE payload length
+//   - u32 LE CRC32 of the payload (IEEE, matching esp_rom_crc32_le)
+//   - u16 LE target device ID (0 = any)
+//   - u8 flags (bit 0: payload is AFLZ-compressed)
+//   - u8 reserved (zero)
+const MAGIC: &[u8; 4] = b"AFBS";
+const AFLZ_MAGIC: &[u8; 4] = b"AFLZ";
+const FLAG_COMPRESSED: u8 = 0x01;
+
+/// Wrap a bitstream (bare or AFLZ-compressed) in the AFBS container so
+/// the loader can verify length and CRC before streaming a single bit.
+pub fn pack_bitstream(input: &str, output: Option<&str>, device_id: u16) -> Result<()> {
+    let input = Path::new(input);
+    let payload = fs::read(input).with_context(|| format!("Failed to read {}", input.display()))?;
+
+    if payload.len() >= 4 && payload[..4] == MAGIC[..] {
+        bail!("{} is already packed", input.display());
+    }
+
+    let compressed = payload.len() >= 4 && payload[..4] == AFLZ_MAGIC[..];
+    let flags = if compressed { FLAG_COMPRESSED } else { 0 };
+    let crc = crc32(&payload);
+
+    let mut image = Vec::with_capacity(16 + payload.len());
+    image.extend_from_slice(MAGIC);
+    image.extend_from_slice(&(payload.len() as u32).to_le_bytes());
+    image.extend_from_slice(&crc.to_le_bytes());
+    image.extend_from_slice(&device_id.to_le_bytes());
+    image.push(flags);
+    image.push(0);
+    image.extend_from_slice(&payload);
+
+    let out_path: PathBuf = match output {
+        Some(path) => PathBuf::from(path),
+        None => PathBuf::from(format!("{}.img", input.display())),
+    };
+    fs::write(&out_path, &image)
+        .with_context(|| format!("Failed to write {}", out_path.display()))?;
+
+    println!(
+        "{}",
+        format!(
+            "==> {} -> {} ({} byte payload, crc32 {:08x}, device id {}, compressed: {})",
+            input.display(),
+            out_path.display(),
+            payload.len(),
+            crc,
+            device_id,
+            if compressed { "yes" } else { "no" },
+        )
+        .blue()
+    );
+
+    Ok(())
+}
+
+fn crc32(data: &[u8]) -> u32 {
+    let mut crc = !0u32;
+    for &byte in data {
+        crc ^= byte as u32;
+        for _ in 0..8 {
+            crc = if crc & 1 != 0 {
+                (crc >> 1) ^ 0xEDB8_8320
+            } else {
+                crc >> 1
+            };
+        }
+    }
+    !crc
+}
@@ -1,55 +1,216 @@
 #include "ice40/fpga_loader.h"
+#include "ice40/fpga_image.h"
+#include "ice40/ice40_reg.h"
 #include "ice40/master_spi.h"
 
 #include <driver/gpio.h>
 #include <driver/spi_master.h>
+#include <esp_attr.h>
 #include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <esp_rom_sys.h>
 #include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include <freertos/semphr.h>
+#include <freertos/stream_buffer.h>
 #include <freertos/task.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <nvs.h>
 #include <soc/gpio_sig_map.h>
+#include <soc/gpio_struct.h>
 #include <soc/soc.h>
+#include <soc/soc_memory_layout.h>
 #include <rom/gpio.h>
 
+#include <stdlib.h>
 #include <string.h>
-#include <sys/stat.h>
 
 #define LOADER_BUFFER_SIZE (CONFIG_FPGA_SPI_BUFFER_SIZE * 4)
 
+// Number of in-flight DMA buffers during bitstream streaming. With two
+// buffers the next chunk is read from the source while the previous one
+// is still clocking out, so source latency hides behind SPI transfer time.
+#define LOADER_PIPELINE_DEPTH 2
+
 static const char *TAG = "ice40_loader";
 
-static spi_device_handle_t fpga_update_device = NULL;
+// Breakdown of the most recent load, see fpga_loader_get_last_stats()
+static fpga_loader_stats_t last_stats;
+
+// Record of the image currently in the FPGA, kept in RTC memory so it
+// survives warm restarts (esp_restart, brownout recovery). Used by
+// fpga_loader_load_from_rom_if_needed() to skip redundant reloads.
+#define LOADED_IMAGE_MAGIC 0x49434534  // "ICE4"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t crc;
+} loaded_image_record_t;
+
+static RTC_NOINIT_ATTR loaded_image_record_t loaded_image;
+
+// Programming clock selection. The Kconfig value is the conservative
+// floor; fpga_loader_calibrate() can find this board's actual ceiling
+// and persist it, after which it is picked up lazily from NVS.
+#define LOADER_NVS_NAMESPACE "ice40"
+#define LOADER_NVS_KEY_PROG_FREQ "prog_freq"
+#define LOADER_MAX_PROG_FREQ_MHZ 25  // ICE40 programming clock limit
+
+static int32_t calibrated_freq_mhz = 0;  // 0 = use Kconfig default
+static bool calibrated_freq_checked = false;
+static int freq_override_mhz = 0;        // Nonzero only during calibration trials
+
+static void loaded_image_invalidate(void)
+{
+    loaded_image.magic = 0;
+}
+
+static void loaded_image_store(uint32_t crc)
+{
+    loaded_image.crc = crc;
+    loaded_image.magic = LOADED_IMAGE_MAGIC;
+}
+
+static bool loaded_image_matches(uint32_t crc)
+{
+    return loaded_image.magic == LOADED_IMAGE_MAGIC && loaded_image.crc == crc;
+}
+
+// Persistent loader state: the programming SPI device plus the streaming
+// DMA buffers, kept across loads by the fpga_loader_ctx API so a warm
+// reload only pays for the bitstream transfer itself
+struct fpga_loader_ctx {
+    fpga_dev_t dev;
+    uint8_t *buffer;    // LOADER_PIPELINE_DEPTH contiguous chunk buffers
+    size_t chunk_size;  // Per-transaction chunk size, picked at init
+    bool dual_core;     // Run source reads on the other core (where present)
+};
+
+// The board's default (and usually only) FPGA, wired per Kconfig
+static const fpga_dev_t default_dev = {
+    .cs_gpio = CONFIG_FPGA_CS_GPIO,
+    .creset_gpio = CONFIG_FPGA_CRESET_GPIO,
+    .cdone_gpio = CONFIG_FPGA_CDONE_GPIO,
+};
 
 typedef struct {
     size_t size;
     void *ctx;
     size_t (*read)(void *buffer, size_t size, void *ctx);
+    // Optional zero-copy path: yields a direct pointer to the next run of
+    // bytes and its length (up to max_size; sources backed by fragmented
+    // memory may yield less at a fragment boundary), advancing the source
+    // position. NULL falls back to read().
+    const uint8_t *(*next_chunk)(size_t max_size, size_t *out_size, void *ctx);
+    // Optional end-of-stream hook, called after the last chunk has been
+    // queued and before the CDONE wait. Lets a container-backed source
+    // fail the load (e.g. on a payload CRC mismatch) without spending
+    // the CDONE timeout on a bitstream already known to be corrupt.
+    esp_err_t (*finish)(void *ctx);
 } firmware_source_t;
 
-static esp_err_t update_spi_device_add(void)
+static int programming_freq_mhz(void)
+{
+    if (freq_override_mhz > 0) {
+        return freq_override_mhz;
+    }
+
+    if (!calibrated_freq_checked) {
+        calibrated_freq_checked = true;
+        nvs_handle_t nvs;
+        if (nvs_open(LOADER_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+            int32_t freq = 0;
+            if (nvs_get_i32(nvs, LOADER_NVS_KEY_PROG_FREQ, &freq) == ESP_OK &&
+                freq >= 1 && freq <= LOADER_MAX_PROG_FREQ_MHZ) {
+                calibrated_freq_mhz = freq;
+                ESP_LOGI(TAG, "Using calibrated programming frequency: %d MHz", freq);
+            }
+            nvs_close(nvs);
+        }
+    }
+
+    return (calibrated_freq_mhz > 0) ? calibrated_freq_mhz
+                                     : CONFIG_FPGA_SPI_FREQ_PROGRAMMING;
+}
+
+// CS is driven from the SPI driver's pre-transfer callback rather than
+// with gpio_set_level() calls between blocks: the callback is
+// IRAM-resident, so the ICE40 keeps seeing a clean select even when a
+// concurrent flash write disables the cache mid-load. The level for each
+// transaction rides in trans->user; bitstream chunks leave it at NULL
+// (CS asserted), clock trains set LOADER_TRANS_CS_HIGH. A negative
+// loader_cs_gpio disables the callback for paths that steer CS
+// themselves (interleaved dual-FPGA loads).
+#define LOADER_TRANS_CS_HIGH ((void *)1)
+
+static volatile int loader_cs_gpio = -1;
+
+static inline void IRAM_ATTR loader_cs_set(int gpio, int level)
+{
+    if (gpio < 32) {
+        if (level) {
+            GPIO.out_w1ts = 1UL << gpio;
+        } else {
+            GPIO.out_w1tc = 1UL << gpio;
+        }
+    } else {
+        if (level) {
+            GPIO.out1_w1ts.val = 1UL << (gpio - 32);
+        } else {
+            GPIO.out1_w1tc.val = 1UL << (gpio - 32);
+        }
+    }
+}
+
+static void IRAM_ATTR loader_spi_pre_cb(spi_transaction_t *trans)
+{
+    int gpio = loader_cs_gpio;
+    if (gpio >= 0) {
+        loader_cs_set(gpio, trans->user == LOADER_TRANS_CS_HIGH);
+    }
+}
+
+// Per-transaction chunk size, decided when the context is created.
+// CONFIG_FPGA_SPI_BUFFER_SIZE * 4 stays the floor; when plenty of
+// DMA-capable memory is free the chunks grow — up to the bus's
+// configured transfer ceiling — so a load spends fewer interrupts and
+// retire round-trips per byte. An eighth of the largest free block
+// keeps the pipeline buffers from starving the rest of the system.
+static size_t loader_chunk_size(void)
+{
+    size_t chunk = heap_caps_get_largest_free_block(MALLOC_CAP_DMA) / 8;
+
+    if (chunk > MASTER_SPI_MAX_TRANSFER) {
+        chunk = MASTER_SPI_MAX_TRANSFER;
+    }
+    if (chunk < LOADER_BUFFER_SIZE) {
+        chunk = LOADER_BUFFER_SIZE;
+    }
+    return chunk & ~(size_t)3;
+}
+
+static esp_err_t update_spi_device_add(spi_device_handle_t *out_device)
 {
     spi_device_interface_config_t devcfg = {
-        .clock_speed_hz = CONFIG_FPGA_SPI_FREQ_PROGRAMMING * 1000000,
+        .clock_speed_hz = programming_freq_mhz() * 1000000,
         .mode = 3,  // ICE40 programming uses SPI Mode 3
-        .spics_io_num = -1,  // Manual CS control
-        .queue_size = 1,
+        .spics_io_num = -1,  // CS driven from loader_spi_pre_cb()
+        .queue_size = LOADER_PIPELINE_DEPTH,
         .command_bits = 0,
         .address_bits = 0,
         .dummy_bits = 0,
         .flags = SPI_DEVICE_HALFDUPLEX,
+        .pre_cb = loader_spi_pre_cb,
     };
 
-    return spi_bus_add_device(FSPI_HOST, &devcfg, &fpga_update_device);
-}
-
-static esp_err_t update_spi_device_remove(void)
-{
-    esp_err_t ret = spi_bus_remove_device(fpga_update_device);
-    fpga_update_device = NULL;
-    return ret;
+    return spi_bus_add_device(FSPI_HOST, &devcfg, out_device);
 }
 
-static esp_err_t write_update_block(const uint8_t *buffer, int length)
+// Clock train with CS deasserted (dummy clocks, CDONE wakeup, I/O
+// activation). Bitstream data goes through the streaming loops instead.
+static esp_err_t IRAM_ATTR write_update_block(spi_device_handle_t device,
+                                              const uint8_t *buffer, int length)
 {
     if (length > LOADER_BUFFER_SIZE) {
         ESP_LOGE(TAG, "Block too large: %d > %d", length, LOADER_BUFFER_SIZE);
@@ -60,236 +221,2252 @@ static esp_err_t write_update_block(const uint8_t *buffer, int length)
         .length = length * 8,
         .tx_buffer = buffer,
         .rx_buffer = NULL,
+        .user = LOADER_TRANS_CS_HIGH,
     };
 
-    xSemaphoreTake(master_spi_semaphore, portMAX_DELAY);
-    esp_err_t ret = spi_device_transmit(fpga_update_device, &trans);
-    xSemaphoreGive(master_spi_semaphore);
+    // No locking needed: the loader holds the bus via
+    // spi_device_acquire_bus() for the whole programming sequence
+    return spi_device_transmit(device, &trans);
+}
 
-    return ret;
+static void reset_pin_set(const fpga_dev_t *dev, bool value)
+{
+    gpio_set_level(dev->creset_gpio, value ? 1 : 0);
+}
+
+// Hand CS back after a load: hardware CS for the default device, plain
+// GPIO (deasserted) for additional devices on the shared bus
+static void cs_pin_restore(const fpga_dev_t *dev)
+{
+    gpio_set_level(dev->cs_gpio, 1);
+    if (dev->cs_gpio == CONFIG_FPGA_CS_GPIO) {
+        gpio_matrix_out(dev->cs_gpio, FSPICS0_OUT_IDX, false, false);
+    }
+}
+
+// Task blocked in cdone_pin_wait(), woken from the CDONE edge ISR
+static TaskHandle_t cdone_wait_task = NULL;
+
+static void IRAM_ATTR cdone_isr_handler(void *arg)
+{
+    TaskHandle_t task = cdone_wait_task;
+    if (task != NULL) {
+        BaseType_t higher_prio_woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &higher_prio_woken);
+        if (higher_prio_woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
 }
 
-static void reset_pin_set(bool value)
+static esp_err_t cdone_pin_wait(const fpga_dev_t *dev, bool value, uint32_t timeout_ms)
 {
-    gpio_set_level(CONFIG_FPGA_CRESET_GPIO, value ? 1 : 0);
+    if (gpio_get_level(dev->cdone_gpio) == (int)value) {
+        return ESP_OK;
+    }
+
+    // Arm an edge interrupt and sleep until it fires, rather than polling
+    // at FreeRTOS tick granularity
+    cdone_wait_task = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);  // Discard any stale notification
+
+    gpio_set_intr_type(dev->cdone_gpio, value ? GPIO_INTR_POSEDGE : GPIO_INTR_NEGEDGE);
+    gpio_isr_handler_add(dev->cdone_gpio, cdone_isr_handler, NULL);
+    gpio_intr_enable(dev->cdone_gpio);
+
+    esp_err_t ret = ESP_OK;
+
+    // Re-check after arming: the edge may have come before the interrupt
+    // was enabled
+    if (gpio_get_level(dev->cdone_gpio) != (int)value) {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) == 0 &&
+            gpio_get_level(dev->cdone_gpio) != (int)value) {
+            ret = ESP_ERR_TIMEOUT;
+        }
+    }
+
+    gpio_intr_disable(dev->cdone_gpio);
+    gpio_isr_handler_remove(dev->cdone_gpio);
+    cdone_wait_task = NULL;
+
+    return ret;
 }
 
-static esp_err_t cdone_pin_wait(bool value, uint32_t timeout_ms)
+// Fill one chunk from the source ahead of transmission. Prefers the
+// zero-copy path: *tx_buffer points straight into the source's memory
+// when the DMA engine can reach it, and into chunk_buffer otherwise.
+// Fragmented sources may shrink *chunk at a fragment boundary.
+static esp_err_t IRAM_ATTR source_fill_chunk(firmware_source_t *source, uint8_t *chunk_buffer,
+                                   size_t *chunk, const uint8_t **tx_buffer)
 {
-    TickType_t timeout = xTaskGetTickCount() + pdMS_TO_TICKS(timeout_ms);
+    *tx_buffer = chunk_buffer;
 
-    while (gpio_get_level(CONFIG_FPGA_CDONE_GPIO) != (int)value) {
-        if (xTaskGetTickCount() > timeout) {
-            return ESP_ERR_TIMEOUT;
+    const uint8_t *direct = NULL;
+    if (source->next_chunk != NULL) {
+        size_t got = 0;
+        direct = source->next_chunk(*chunk, &got, source->ctx);
+        if (direct != NULL) {
+            if (got == 0 || got > *chunk) {
+                ESP_LOGE(TAG, "Bad source fragment length: %d", got);
+                return ESP_FAIL;
+            }
+            *chunk = got;
         }
-        vTaskDelay(1);
     }
 
+    if (direct != NULL && esp_ptr_dma_capable(direct)) {
+        *tx_buffer = direct;
+    } else if (direct != NULL) {
+        memcpy(chunk_buffer, direct, *chunk);
+    } else {
+        size_t read = source->read(chunk_buffer, *chunk, source->ctx);
+        if (read != *chunk) {
+            ESP_LOGE(TAG, "Read error: expected %d, got %d", *chunk, read);
+            return ESP_FAIL;
+        }
+    }
     return ESP_OK;
 }
 
-static esp_err_t fpga_loader_load(firmware_source_t *source)
+// Step 7, single-task variant: read the next chunk from the source while
+// the previous one is still clocking out
+static esp_err_t IRAM_ATTR stream_pipelined(fpga_loader_ctx_t *ctx, firmware_source_t *source,
+                                            fpga_loader_stats_t *stats)
+{
+    esp_err_t ret = ESP_OK;
+    spi_transaction_t trans[LOADER_PIPELINE_DEPTH];
+    size_t remaining = source->size;
+    int queued = 0;
+    int slot = 0;
+    int64_t t_phase;
+
+    while (remaining > 0 || queued > 0) {
+        if (remaining > 0 && queued < LOADER_PIPELINE_DEPTH) {
+            // A buffer is free: fill it from the source and queue it
+            size_t chunk = (remaining > ctx->chunk_size) ? ctx->chunk_size : remaining;
+            uint8_t *chunk_buffer = ctx->buffer + (slot * ctx->chunk_size);
+            const uint8_t *tx_buffer;
+
+            t_phase = esp_timer_get_time();
+            ret = source_fill_chunk(source, chunk_buffer, &chunk, &tx_buffer);
+            stats->source_read_us += esp_timer_get_time() - t_phase;
+            if (ret != ESP_OK) {
+                break;
+            }
+
+            memset(&trans[slot], 0, sizeof(spi_transaction_t));
+            trans[slot].length = chunk * 8;
+            trans[slot].tx_buffer = tx_buffer;
+
+            ret = spi_device_queue_trans(ctx->dev.device, &trans[slot], portMAX_DELAY);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Write error: %s", esp_err_to_name(ret));
+                break;
+            }
+
+            slot = (slot + 1) % LOADER_PIPELINE_DEPTH;
+            queued++;
+            remaining -= chunk;
+            stats->chunks++;
+        } else {
+            // All buffers in flight (or source drained): retire the oldest
+            spi_transaction_t *completed;
+            t_phase = esp_timer_get_time();
+            ret = spi_device_get_trans_result(ctx->dev.device, &completed, portMAX_DELAY);
+            stats->spi_wait_us += esp_timer_get_time() - t_phase;
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Transmit error: %s", esp_err_to_name(ret));
+                break;
+            }
+            queued--;
+        }
+    }
+
+    // On error, drain any transactions still in flight before reusing buffers
+    while (queued > 0) {
+        spi_transaction_t *completed;
+        spi_device_get_trans_result(ctx->dev.device, &completed, portMAX_DELAY);
+        queued--;
+    }
+
+    stats->bytes = source->size - remaining;
+    return ret;
+}
+
+// Chunk handoff from the reader task to the SPI-submitting task in
+// dual-core mode. length == 0 marks the end of the stream (err carries
+// the reader's verdict).
+typedef struct {
+    uint8_t *slot;      // Chunk buffer to recycle once transmitted
+    const uint8_t *tx;  // Bytes to transmit (may point into the source)
+    size_t length;
+    esp_err_t err;
+} stream_chunk_t;
+
+typedef struct {
+    firmware_source_t *source;
+    size_t chunk_size;          // The owning context's per-chunk size
+    QueueHandle_t free_slots;   // uint8_t *: buffers the reader may fill
+    QueueHandle_t full_chunks;  // stream_chunk_t: filled, ready to transmit
+    int64_t read_us;
+} stream_reader_args_t;
+
+static void stream_reader_task(void *arg)
+{
+    stream_reader_args_t *ra = (stream_reader_args_t *)arg;
+    size_t remaining = ra->source->size;
+
+    while (remaining > 0) {
+        uint8_t *slot;
+        xQueueReceive(ra->free_slots, &slot, portMAX_DELAY);
+
+        stream_chunk_t item = {
+            .slot = slot,
+            .length = (remaining > ra->chunk_size) ? ra->chunk_size : remaining,
+        };
+
+        int64_t t = esp_timer_get_time();
+        item.err = source_fill_chunk(ra->source, slot, &item.length, &item.tx);
+        ra->read_us += esp_timer_get_time() - t;
+
+        if (item.err != ESP_OK) {
+            item.length = 0;
+            xQueueSend(ra->full_chunks, &item, portMAX_DELAY);
+            vTaskDelete(NULL);
+            return;
+        }
+
+        remaining -= item.length;
+        xQueueSend(ra->full_chunks, &item, portMAX_DELAY);
+    }
+
+    stream_chunk_t end = {.err = ESP_OK};
+    xQueueSend(ra->full_chunks, &end, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
+
+// Step 7, dual-core variant: source reads run as a task pinned to the
+// other core, so flash reads and decompression don't serialize with
+// bitstream clocking or with this core's interrupt load (WiFi)
+static esp_err_t stream_dual_core(fpga_loader_ctx_t *ctx, firmware_source_t *source,
+                                  fpga_loader_stats_t *stats)
+{
+    esp_err_t ret = ESP_OK;
+
+    stream_reader_args_t ra = {
+        .source = source,
+        .chunk_size = ctx->chunk_size,
+        .free_slots = xQueueCreate(LOADER_PIPELINE_DEPTH, sizeof(uint8_t *)),
+        .full_chunks = xQueueCreate(LOADER_PIPELINE_DEPTH, sizeof(stream_chunk_t)),
+    };
+
+    BaseType_t other_core = (xPortGetCoreID() == 0) ? 1 : 0;
+    bool started = ra.free_slots != NULL && ra.full_chunks != NULL;
+    if (started) {
+        for (int i = 0; i < LOADER_PIPELINE_DEPTH; i++) {
+            uint8_t *slot = ctx->buffer + (i * ctx->chunk_size);
+            xQueueSend(ra.free_slots, &slot, portMAX_DELAY);
+        }
+        started = xTaskCreatePinnedToCore(stream_reader_task, "fpga_read", 3072,
+                                          &ra, 10, NULL, other_core) == pdPASS;
+    }
+    if (!started) {
+        // Degrade gracefully rather than failing the load
+        ESP_LOGW(TAG, "Dual-core reader unavailable, using single-task pipeline");
+        if (ra.free_slots != NULL) {
+            vQueueDelete(ra.free_slots);
+        }
+        if (ra.full_chunks != NULL) {
+            vQueueDelete(ra.full_chunks);
+        }
+        return stream_pipelined(ctx, source, stats);
+    }
+
+    spi_transaction_t trans[LOADER_PIPELINE_DEPTH];
+    uint8_t *retire_slot[LOADER_PIPELINE_DEPTH];
+    int queued = 0;
+    int slot = 0;
+    int retire = 0;
+    bool reader_done = false;
+    int64_t t_phase;
+
+    while (true) {
+        stream_chunk_t item;
+        xQueueReceive(ra.full_chunks, &item, portMAX_DELAY);
+        if (item.length == 0) {
+            reader_done = true;
+            ret = item.err;
+            break;
+        }
+
+        if (queued == LOADER_PIPELINE_DEPTH) {
+            // All transactions in flight: retire the oldest and hand its
+            // buffer back to the reader
+            spi_transaction_t *completed;
+            t_phase = esp_timer_get_time();
+            ret = spi_device_get_trans_result(ctx->dev.device, &completed, portMAX_DELAY);
+            stats->spi_wait_us += esp_timer_get_time() - t_phase;
+            queued--;
+            xQueueSend(ra.free_slots, &retire_slot[retire], portMAX_DELAY);
+            retire = (retire + 1) % LOADER_PIPELINE_DEPTH;
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Transmit error: %s", esp_err_to_name(ret));
+                xQueueSend(ra.free_slots, &item.slot, portMAX_DELAY);
+                break;
+            }
+        }
+
+        memset(&trans[slot], 0, sizeof(spi_transaction_t));
+        trans[slot].length = item.length * 8;
+        trans[slot].tx_buffer = item.tx;
+        retire_slot[slot] = item.slot;
+
+        ret = spi_device_queue_trans(ctx->dev.device, &trans[slot], portMAX_DELAY);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Write error: %s", esp_err_to_name(ret));
+            xQueueSend(ra.free_slots, &item.slot, portMAX_DELAY);
+            break;
+        }
+
+        slot = (slot + 1) % LOADER_PIPELINE_DEPTH;
+        queued++;
+        stats->bytes += item.length;
+        stats->chunks++;
+    }
+
+    // Drain in-flight transactions, recycling buffers as they retire
+    while (queued > 0) {
+        spi_transaction_t *completed;
+        spi_device_get_trans_result(ctx->dev.device, &completed, portMAX_DELAY);
+        queued--;
+        xQueueSend(ra.free_slots, &retire_slot[retire], portMAX_DELAY);
+        retire = (retire + 1) % LOADER_PIPELINE_DEPTH;
+    }
+
+    // The reader's queues live on this stack: keep feeding it buffers
+    // until its end-of-stream marker arrives, even after an error
+    while (!reader_done) {
+        stream_chunk_t item;
+        xQueueReceive(ra.full_chunks, &item, portMAX_DELAY);
+        if (item.length == 0) {
+            reader_done = true;
+        } else {
+            xQueueSend(ra.free_slots, &item.slot, portMAX_DELAY);
+        }
+    }
+
+    stats->source_read_us += ra.read_us;
+
+    vQueueDelete(ra.free_slots);
+    vQueueDelete(ra.full_chunks);
+    return ret;
+}
+
+// ROM source implementation
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+} rom_ctx_t;
+
+static size_t rom_read(void *buffer, size_t size, void *ctx)
+{
+    rom_ctx_t *rom = (rom_ctx_t *)ctx;
+
+    if (rom->pos + size > rom->size) {
+        return 0;
+    }
+
+    memcpy(buffer, rom->data + rom->pos, size);
+    rom->pos += size;
+    return size;
+}
+
+static const uint8_t *rom_next_chunk(size_t max_size, size_t *out_size, void *ctx)
+{
+    rom_ctx_t *rom = (rom_ctx_t *)ctx;
+
+    size_t avail = rom->size - rom->pos;
+    if (avail == 0) {
+        return NULL;
+    }
+
+    const uint8_t *ptr = rom->data + rom->pos;
+    *out_size = (avail < max_size) ? avail : max_size;
+    rom->pos += *out_size;
+    return ptr;
+}
+
+static esp_err_t fpga_loader_load(fpga_loader_ctx_t *ctx, firmware_source_t *source)
 {
     esp_err_t ret;
 
-    ret = update_spi_device_add();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to add SPI device: %s", esp_err_to_name(ret));
-        return ret;
+    fpga_loader_stats_t stats = {0};
+    int64_t t_start = esp_timer_get_time();
+    int64_t t_phase;
+
+    // On PSRAM-equipped modules, pull a slow byte source into memory
+    // once and stream it in maximal chunks: the bus is then held only
+    // for the SPI transfer itself, and a container CRC verdict arrives
+    // before the FPGA is even reset. DMA can't reach PSRAM on the S2,
+    // so chunks still bounce through the internal pipeline buffers.
+    uint8_t *staged = NULL;
+    rom_ctx_t staged_rom;
+    firmware_source_t staged_source;
+    if (source->next_chunk == NULL &&
+        heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) > source->size) {
+        staged = heap_caps_malloc(source->size, MALLOC_CAP_SPIRAM);
+    }
+    if (staged != NULL) {
+        int64_t t_stage = esp_timer_get_time();
+        size_t got = 0;
+        while (got < source->size) {
+            size_t n = source->read(staged + got, source->size - got, source->ctx);
+            if (n == 0) {
+                break;
+            }
+            got += n;
+        }
+        if (got != source->size) {
+            ESP_LOGE(TAG, "Staging read error: expected %d, got %d", source->size, got);
+            heap_caps_free(staged);
+            return ESP_FAIL;
+        }
+        if (source->finish != NULL) {
+            ret = source->finish(source->ctx);
+            if (ret != ESP_OK) {
+                heap_caps_free(staged);
+                return ret;
+            }
+        }
+        stats.source_read_us = esp_timer_get_time() - t_stage;
+
+        staged_rom = (rom_ctx_t){.data = staged, .size = source->size};
+        staged_source = (firmware_source_t){
+            .size = source->size,
+            .ctx = &staged_rom,
+            .read = rom_read,
+            .next_chunk = rom_next_chunk,
+        };
+        source = &staged_source;
+        ESP_LOGI(TAG, "Staged %d bytes in PSRAM", staged_rom.size);
     }
 
-    ret = spi_device_acquire_bus(fpga_update_device, portMAX_DELAY);
+    // Whatever was configured is about to be overwritten (or trashed by a
+    // failed load); only a successful *_if_needed() path re-records it
+    loaded_image_invalidate();
+
+    ret = spi_device_acquire_bus(ctx->dev.device, portMAX_DELAY);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to acquire SPI bus: %s", esp_err_to_name(ret));
-        goto cleanup_device;
+        heap_caps_free(staged);
+        return ret;
     }
 
     // ICE40 Programming Sequence (TN1248, Figure 13.3)
 
     // Step 1: Drive CRESET_B = 0
-    reset_pin_set(0);
+    reset_pin_set(&ctx->dev, 0);
 
-    // Step 2: Drive SPI_SS_B = 0
-    gpio_set_level(CONFIG_FPGA_CS_GPIO, 0);
-    gpio_matrix_out(CONFIG_FPGA_CS_GPIO, SIG_GPIO_OUT_IDX, false, false);
+    // Step 2: Drive SPI_SS_B = 0 (from here on the pre-transfer callback
+    // owns the pin)
+    gpio_set_level(ctx->dev.cs_gpio, 0);
+    gpio_matrix_out(ctx->dev.cs_gpio, SIG_GPIO_OUT_IDX, false, false);
+    loader_cs_gpio = ctx->dev.cs_gpio;
 
     // Step 3: Wait minimum 200ns
-    vTaskDelay(1);
+    esp_rom_delay_us(1);
 
     // Step 4: Release CRESET_B
-    reset_pin_set(1);
+    reset_pin_set(&ctx->dev, 1);
 
     // Step 5: Wait minimum 1200us
-    vTaskDelay(pdMS_TO_TICKS(2));
+    esp_rom_delay_us(1300);
 
-    // Step 6: Set SPI_SS_B = 1, send 8 dummy clocks
-    gpio_set_level(CONFIG_FPGA_CS_GPIO, 1);
+    // Step 6: Set SPI_SS_B = 1, send 8 dummy clocks (CS is raised by the
+    // dummy block's pre-transfer callback and drops again with the first
+    // bitstream chunk)
     {
         uint8_t dummy[1] = {0};
-        ret = write_update_block(dummy, sizeof(dummy));
+        ret = write_update_block(ctx->dev.device, dummy, sizeof(dummy));
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Failed to send dummy clocks");
             goto cleanup_bus;
         }
     }
-    gpio_set_level(CONFIG_FPGA_CS_GPIO, 0);
 
-    // Step 7: Send configuration bitstream
-    uint8_t *buffer = heap_caps_malloc(LOADER_BUFFER_SIZE, MALLOC_CAP_DMA);
-    if (buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate DMA buffer");
-        ret = ESP_ERR_NO_MEM;
-        goto cleanup_bus;
-    }
+    stats.reset_us = esp_timer_get_time() - t_start;
 
-    size_t remaining = source->size;
-    ESP_LOGI(TAG, "Loading %d bytes", remaining);
+    // Step 7: Send configuration bitstream
+    int64_t t_stream = esp_timer_get_time();
+    uint8_t *buffer = ctx->buffer;
 
-    while (remaining > 0) {
-        size_t chunk = (remaining > LOADER_BUFFER_SIZE) ? LOADER_BUFFER_SIZE : remaining;
+    ESP_LOGI(TAG, "Loading %d bytes", source->size);
 
-        size_t read = source->read(buffer, chunk, source->ctx);
-        if (read != chunk) {
-            ESP_LOGE(TAG, "Read error: expected %d, got %d", chunk, read);
-            ret = ESP_FAIL;
-            break;
-        }
+    if (ctx->dual_core && portNUM_PROCESSORS > 1) {
+        ret = stream_dual_core(ctx, source, &stats);
+    } else {
+        ret = stream_pipelined(ctx, source, &stats);
+    }
 
-        ret = write_update_block(buffer, chunk);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Write error");
-            break;
-        }
+    stats.stream_us = esp_timer_get_time() - t_stream;
 
-        remaining -= chunk;
+    // Give the source its verdict on what just streamed (incremental
+    // container CRC); a mismatch skips the pointless 100ms CDONE wait
+    if (ret == ESP_OK && source->finish != NULL) {
+        ret = source->finish(source->ctx);
     }
 
-    // Step 8: Wait for CDONE (send 100+ clocks)
-    gpio_set_level(CONFIG_FPGA_CS_GPIO, 1);
+    // Step 8: Wait for CDONE (send 100+ clocks, CS deasserted)
     memset(buffer, 0, LOADER_BUFFER_SIZE);
-    write_update_block(buffer, 13);  // 13 * 8 = 104 clocks
+    write_update_block(ctx->dev.device, buffer, 13);  // 13 * 8 = 104 clocks
 
-    ret = cdone_pin_wait(true, 100);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "CDONE timeout - configuration failed");
+    if (ret == ESP_OK) {
+        t_phase = esp_timer_get_time();
+        ret = cdone_pin_wait(&ctx->dev, true, 100);
+        stats.cdone_wait_us = esp_timer_get_time() - t_phase;
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "CDONE timeout - configuration failed");
+        }
     }
 
     // Step 9: Send 49+ additional clocks to activate I/O
-    write_update_block(buffer, 7);  // 7 * 8 = 56 clocks
+    write_update_block(ctx->dev.device, buffer, 7);  // 7 * 8 = 56 clocks
 
     // Step 10: Restore CS to hardware control
-    gpio_set_level(CONFIG_FPGA_CS_GPIO, 1);
-    gpio_matrix_out(CONFIG_FPGA_CS_GPIO, FSPICS0_OUT_IDX, false, false);
+    cs_pin_restore(&ctx->dev);
 
-    heap_caps_free(buffer);
+    stats.total_us = esp_timer_get_time() - t_start;
+    if (stats.stream_us > 0) {
+        stats.mbytes_per_sec = (float)stats.bytes / (float)stats.stream_us;
+    }
+    last_stats = stats;
 
     if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "FPGA configuration complete");
+        ESP_LOGI(TAG, "FPGA configuration complete: %d bytes in %lld us "
+                 "(reset %lld, read %lld, spi wait %lld, cdone %lld) %.2f MB/s",
+                 stats.bytes, stats.total_us, stats.reset_us,
+                 stats.source_read_us, stats.spi_wait_us, stats.cdone_wait_us,
+                 stats.mbytes_per_sec);
     }
 
 cleanup_bus:
-    spi_device_release_bus(fpga_update_device);
-
-cleanup_device:
-    update_spi_device_remove();
+    loader_cs_gpio = -1;
+    spi_device_release_bus(ctx->dev.device);
+    heap_caps_free(staged);
 
     return ret;
 }
 
-// ROM source implementation
+// Scatter-gather source implementation: a chain of caller-owned fragments
+// (e.g. network buffers from an OTA download), streamed in place where the
+// DMA engine can reach them
 typedef struct {
-    const uint8_t *data;
-    size_t size;
-    size_t pos;
-} rom_ctx_t;
+    const fpga_loader_frag_t *frags;
+    size_t count;
+    size_t index;   // Current fragment
+    size_t offset;  // Position within the current fragment
+} frag_ctx_t;
 
-static size_t rom_read(void *buffer, size_t size, void *ctx)
+static size_t frag_read(void *buffer, size_t size, void *ctx)
 {
-    rom_ctx_t *rom = (rom_ctx_t *)ctx;
+    frag_ctx_t *fc = (frag_ctx_t *)ctx;
+    uint8_t *out = (uint8_t *)buffer;
+    size_t copied = 0;
 
-    if (rom->pos + size > rom->size) {
-        return 0;
+    while (copied < size && fc->index < fc->count) {
+        const fpga_loader_frag_t *frag = &fc->frags[fc->index];
+        size_t avail = frag->size - fc->offset;
+        size_t take = size - copied;
+        if (take > avail) {
+            take = avail;
+        }
+        memcpy(out + copied, (const uint8_t *)frag->data + fc->offset, take);
+        copied += take;
+        fc->offset += take;
+        if (fc->offset == frag->size) {
+            fc->index++;
+            fc->offset = 0;
+        }
     }
-
-    memcpy(buffer, rom->data + rom->pos, size);
-    rom->pos += size;
-    return size;
+    return copied;
 }
 
-esp_err_t fpga_loader_load_from_rom(const fpga_bin_t *fpga_bin)
+static const uint8_t *frag_next_chunk(size_t max_size, size_t *out_size, void *ctx)
 {
-    if (fpga_bin == NULL || fpga_bin->end <= fpga_bin->start) {
-        ESP_LOGE(TAG, "Invalid FPGA binary");
-        return ESP_ERR_INVALID_ARG;
+    frag_ctx_t *fc = (frag_ctx_t *)ctx;
+
+    while (fc->index < fc->count && fc->offset == fc->frags[fc->index].size) {
+        fc->index++;
+        fc->offset = 0;
+    }
+    if (fc->index >= fc->count) {
+        return NULL;
     }
 
-    rom_ctx_t ctx = {
-        .data = fpga_bin->start,
-        .size = fpga_bin->end - fpga_bin->start,
-        .pos = 0,
-    };
+    const fpga_loader_frag_t *frag = &fc->frags[fc->index];
+    size_t avail = frag->size - fc->offset;
+    const uint8_t *ptr = (const uint8_t *)frag->data + fc->offset;
+    *out_size = (avail < max_size) ? avail : max_size;
+    fc->offset += *out_size;
+    return ptr;
+}
 
-    ESP_LOGI(TAG, "Loading FPGA from ROM, size=%d", ctx.size);
+// Compressed bitstream source implementation
+//
+// Streaming LZSS decompressor for the AFLZ container produced by
+// `affogato compress`. Container layout: 4-byte magic "AFLZ", uint32 LE
+// decompressed size, then a token stream (flag byte consumed MSB-first,
+// 1 = literal byte, 0 = 16-bit big-endian back-reference holding a
+// 12-bit distance-1 and a 4-bit length-3). Decompression runs with a
+// fixed 4KB window; the decompressed image is never materialized.
 
-    firmware_source_t source = {
-        .size = ctx.size,
-        .ctx = &ctx,
-        .read = rom_read,
-    };
+#define LZ_MAGIC "AFLZ"
+#define LZ_WINDOW_SIZE 4096
+#define LZ_MIN_MATCH 3
 
-    return fpga_loader_load(&source);
+typedef struct __attribute__((packed)) {
+    char magic[4];      // "AFLZ"
+    uint32_t raw_size;  // Decompressed size, little-endian
+} lz_header_t;
+
+typedef struct {
+    firmware_source_t *inner;  // Compressed byte source
+    size_t in_remaining;       // Compressed bytes left in inner source
+    uint8_t in_buf[256];       // Staging for inner reads
+    size_t in_len;
+    size_t in_pos;
+    uint8_t window[LZ_WINDOW_SIZE];
+    size_t window_pos;
+    uint8_t flags;             // Current flag byte, consumed MSB-first
+    int flag_bits;             // Unconsumed bits left in flags
+    size_t match_pos;          // Back-reference in progress (carries
+    size_t match_len;          // across read() boundaries)
+} lz_ctx_t;
+
+static int lz_in_byte(lz_ctx_t *lz)
+{
+    if (lz->in_pos >= lz->in_len) {
+        size_t want = sizeof(lz->in_buf);
+        if (want > lz->in_remaining) {
+            want = lz->in_remaining;
+        }
+        if (want == 0) {
+            return -1;
+        }
+        size_t got = lz->inner->read(lz->in_buf, want, lz->inner->ctx);
+        if (got == 0) {
+            return -1;
+        }
+        lz->in_len = got;
+        lz->in_pos = 0;
+        lz->in_remaining -= got;
+    }
+    return lz->in_buf[lz->in_pos++];
 }
 
-// File source implementation
-static size_t file_read(void *buffer, size_t size, void *ctx)
+static esp_err_t lz_finish(void *vctx)
 {
-    return fread(buffer, 1, size, (FILE *)ctx);
+    lz_ctx_t *lz = (lz_ctx_t *)vctx;
+    return (lz->inner->finish != NULL) ? lz->inner->finish(lz->inner->ctx) : ESP_OK;
 }
 
-esp_err_t fpga_loader_load_from_file(const char *filename)
+static size_t lz_read(void *buffer, size_t size, void *ctx)
 {
-    struct stat st;
-    if (stat(filename, &st) == -1) {
-        ESP_LOGE(TAG, "File not found: %s", filename);
-        return ESP_ERR_NOT_FOUND;
-    }
+    lz_ctx_t *lz = (lz_ctx_t *)ctx;
+    uint8_t *out = (uint8_t *)buffer;
+    size_t produced = 0;
 
-    FILE *fp = fopen(filename, "rb");
-    if (fp == NULL) {
-        ESP_LOGE(TAG, "Failed to open: %s", filename);
-        return ESP_FAIL;
-    }
+    while (produced < size) {
+        if (lz->match_len > 0) {
+            // Continue copying an in-progress back-reference
+            uint8_t c = lz->window[lz->match_pos];
+            lz->match_pos = (lz->match_pos + 1) & (LZ_WINDOW_SIZE - 1);
+            lz->match_len--;
+            lz->window[lz->window_pos] = c;
+            lz->window_pos = (lz->window_pos + 1) & (LZ_WINDOW_SIZE - 1);
+            out[produced++] = c;
+            continue;
+        }
 
-    ESP_LOGI(TAG, "Loading FPGA from %s, size=%ld", filename, st.st_size);
+        if (lz->flag_bits == 0) {
+            int flags = lz_in_byte(lz);
+            if (flags < 0) {
+                return produced;
+            }
+            lz->flags = flags;
+            lz->flag_bits = 8;
+        }
 
-    firmware_source_t source = {
-        .size = st.st_size,
-        .ctx = fp,
-        .read = file_read,
-    };
+        bool literal = (lz->flags & 0x80) != 0;
+        lz->flags <<= 1;
+        lz->flag_bits--;
 
-    esp_err_t ret = fpga_loader_load(&source);
-    fclose(fp);
+        if (literal) {
+            int c = lz_in_byte(lz);
+            if (c < 0) {
+                return produced;
+            }
+            lz->window[lz->window_pos] = c;
+            lz->window_pos = (lz->window_pos + 1) & (LZ_WINDOW_SIZE - 1);
+            out[produced++] = c;
+        } else {
+            int hi = lz_in_byte(lz);
+            int lo = lz_in_byte(lz);
+            if (hi < 0 || lo < 0) {
+                return produced;
+            }
+            uint16_t token = (hi << 8) | lo;
+            size_t distance = (token >> 4) + 1;
+            lz->match_len = (token & 0x0F) + LZ_MIN_MATCH;
+            lz->match_pos = (lz->window_pos - distance) & (LZ_WINDOW_SIZE - 1);
+        }
+    }
 
-    return ret;
+    return produced;
 }
 
-esp_err_t fpga_loader_init(void)
+static bool lz_header_present(const uint8_t *data, size_t size)
 {
-    // Configure CRESET as output (active low)
-    gpio_config_t creset_cfg = {
-        .pin_bit_mask = (1ULL << CONFIG_FPGA_CRESET_GPIO),
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
+    return size >= sizeof(lz_header_t) && memcmp(data, LZ_MAGIC, 4) == 0;
+}
+
+// Stored bitstreams may carry an AFBS container header (fpga_image.h).
+// For memory-mapped images the payload length and CRC are verified here,
+// before a single bit is streamed, so a corrupt image fails in
+// microseconds instead of after a full load and CDONE timeout. Narrows
+// *data/*size to the payload; bare images pass through untouched.
+static esp_err_t image_header_consume(const uint8_t **data, size_t *size, bool *compressed)
+{
+    *compressed = false;
+
+    if (*size < sizeof(fpga_image_header_t) ||
+        memcmp(*data, FPGA_IMAGE_MAGIC, 4) != 0) {
+        return ESP_OK;  // Bare bitstream (or AFLZ), stream as-is
+    }
+
+    const fpga_image_header_t *header = (const fpga_image_header_t *)*data;
+    if (header->length > *size - sizeof(*header)) {
+        ESP_LOGE(TAG, "Container payload %u exceeds image size %d",
+                 header->length, *size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const uint8_t *payload = *data + sizeof(*header);
+    uint32_t crc = esp_rom_crc32_le(0, payload, header->length);
+    if (crc != header->crc32) {
+        ESP_LOGE(TAG, "Container CRC mismatch: header %08x, payload %08x",
+                 header->crc32, crc);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    *data = payload;
+    *size = header->length;
+    *compressed = (header->flags & FPGA_IMAGE_FLAG_COMPRESSED) != 0;
+    return ESP_OK;
+}
+
+// CRC-verifying pass-through source. Sits directly over the container
+// payload — below the decompressor for compressed images — so the
+// running CRC matches the AFBS header's crc32 no matter how the payload
+// is encoded. Sources that can't seek get their integrity check this
+// way, incrementally, instead of with a second read of the data.
+typedef struct {
+    firmware_source_t *inner;
+    uint32_t expected;  // crc32 from the container header
+    uint32_t crc;       // Running CRC over consumed payload bytes
+} crc_ctx_t;
+
+static size_t crc_read(void *buffer, size_t size, void *vctx)
+{
+    crc_ctx_t *cc = (crc_ctx_t *)vctx;
+    size_t got = cc->inner->read(buffer, size, cc->inner->ctx);
+    cc->crc = esp_rom_crc32_le(cc->crc, buffer, got);
+    return got;
+}
+
+static const uint8_t *crc_next_chunk(size_t max_size, size_t *out_size, void *vctx)
+{
+    crc_ctx_t *cc = (crc_ctx_t *)vctx;
+    const uint8_t *ptr = cc->inner->next_chunk(max_size, out_size, cc->inner->ctx);
+    if (ptr != NULL) {
+        cc->crc = esp_rom_crc32_le(cc->crc, ptr, *out_size);
+    }
+    return ptr;
+}
+
+static esp_err_t crc_finish(void *vctx)
+{
+    crc_ctx_t *cc = (crc_ctx_t *)vctx;
+    if (cc->crc != cc->expected) {
+        ESP_LOGE(TAG, "Container CRC mismatch: header %08x, payload %08x",
+                 cc->expected, cc->crc);
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+static void crc_source_wrap(firmware_source_t *out, firmware_source_t *inner,
+                            crc_ctx_t *cc, uint32_t expected)
+{
+    cc->inner = inner;
+    cc->expected = expected;
+    cc->crc = 0;
+
+    memset(out, 0, sizeof(*out));
+    out->size = inner->size;
+    out->ctx = cc;
+    out->read = crc_read;
+    out->next_chunk = (inner->next_chunk != NULL) ? crc_next_chunk : NULL;
+    out->finish = crc_finish;
+}
+
+// Wraps a source positioned at an AFLZ header in the streaming
+// decompressor and runs the load
+static esp_err_t fpga_loader_load_compressed(fpga_loader_ctx_t *ctx, firmware_source_t *inner)
+{
+    lz_header_t header;
+    if (inner->read(&header, sizeof(header), inner->ctx) != sizeof(header) ||
+        memcmp(header.magic, LZ_MAGIC, 4) != 0) {
+        ESP_LOGE(TAG, "Bad compressed bitstream header");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The window makes the context too large for the caller's stack
+    lz_ctx_t *lz = heap_caps_calloc(1, sizeof(lz_ctx_t), MALLOC_CAP_DEFAULT);
+    if (lz == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate decompressor context");
+        return ESP_ERR_NO_MEM;
+    }
+
+    lz->inner = inner;
+    lz->in_remaining = inner->size - sizeof(header);
+
+    firmware_source_t source = {
+        .size = header.raw_size,
+        .ctx = lz,
+        .read = lz_read,
+        .finish = lz_finish,
+    };
+
+    ESP_LOGI(TAG, "Decompressing bitstream: %d -> %d bytes",
+             inner->size, header.raw_size);
+
+    esp_err_t ret = fpga_loader_load(ctx, &source);
+
+    heap_caps_free(lz);
+
+    return ret;
+}
+
+esp_err_t fpga_loader_ctx_init_for_dev(fpga_loader_ctx_t **out_ctx, const fpga_dev_t *dev)
+{
+    fpga_loader_ctx_t *ctx = calloc(1, sizeof(fpga_loader_ctx_t));
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->dev = *dev;
+
+    // The heuristic leaves headroom, but another allocator can still
+    // race us to it; fall back to the compile-time floor before giving up
+    ctx->chunk_size = loader_chunk_size();
+    ctx->buffer = heap_caps_malloc(ctx->chunk_size * LOADER_PIPELINE_DEPTH, MALLOC_CAP_DMA);
+    if (ctx->buffer == NULL && ctx->chunk_size > LOADER_BUFFER_SIZE) {
+        ctx->chunk_size = LOADER_BUFFER_SIZE;
+        ctx->buffer = heap_caps_malloc(ctx->chunk_size * LOADER_PIPELINE_DEPTH, MALLOC_CAP_DMA);
+    }
+    if (ctx->buffer == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate DMA buffers");
+        free(ctx);
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = update_spi_device_add(&ctx->dev.device);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add SPI device: %s", esp_err_to_name(ret));
+        heap_caps_free(ctx->buffer);
+        free(ctx);
+        return ret;
+    }
+
+    *out_ctx = ctx;
+    return ESP_OK;
+}
+
+esp_err_t fpga_loader_ctx_init(fpga_loader_ctx_t **out_ctx)
+{
+    return fpga_loader_ctx_init_for_dev(out_ctx, &default_dev);
+}
+
+esp_err_t fpga_loader_ctx_deinit(fpga_loader_ctx_t *ctx)
+{
+    if (ctx == NULL) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = spi_bus_remove_device(ctx->dev.device);
+    heap_caps_free(ctx->buffer);
+    free(ctx);
+    return ret;
+}
+
+esp_err_t fpga_loader_ctx_set_dual_core(fpga_loader_ctx_t *ctx, bool enable)
+{
+    if (ctx == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (enable && portNUM_PROCESSORS < 2) {
+        ESP_LOGD(TAG, "Single-core target, dual-core loads degrade to pipelined");
+    }
+    ctx->dual_core = enable;
+    return ESP_OK;
+}
+
+esp_err_t fpga_loader_ctx_load_from_rom(fpga_loader_ctx_t *ctx, const fpga_bin_t *fpga_bin)
+{
+    if (fpga_bin == NULL || fpga_bin->end <= fpga_bin->start) {
+        ESP_LOGE(TAG, "Invalid FPGA binary");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint8_t *data = fpga_bin->start;
+    size_t size = fpga_bin->end - fpga_bin->start;
+    bool compressed;
+
+    esp_err_t ret = image_header_consume(&data, &size, &compressed);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    rom_ctx_t rom = {
+        .data = data,
+        .size = size,
+        .pos = 0,
+    };
+
+    ESP_LOGI(TAG, "Loading FPGA from ROM, size=%d", rom.size);
+
+    firmware_source_t source = {
+        .size = rom.size,
+        .ctx = &rom,
+        .read = rom_read,
+        .next_chunk = rom_next_chunk,
+    };
+
+    if (compressed || lz_header_present(rom.data, rom.size)) {
+        return fpga_loader_load_compressed(ctx, &source);
+    }
+
+    return fpga_loader_load(ctx, &source);
+}
+
+esp_err_t fpga_loader_ctx_load_from_partition(fpga_loader_ctx_t *ctx, const char *label, size_t size)
+{
+    const esp_partition_t *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "Partition not found: %s", label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (size == 0) {
+        size = partition->size;
+    } else if (size > partition->size) {
+        ESP_LOGE(TAG, "Bitstream larger than partition: %d > %d", size, partition->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const void *mapped;
+    spi_flash_mmap_handle_t map_handle;
+    esp_err_t ret = esp_partition_mmap(partition, 0, size, SPI_FLASH_MMAP_DATA,
+                                       &mapped, &map_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map partition %s: %s", label, esp_err_to_name(ret));
+        return ret;
+    }
+
+    const uint8_t *data = mapped;
+    bool compressed;
+    ret = image_header_consume(&data, &size, &compressed);
+    if (ret != ESP_OK) {
+        spi_flash_munmap(map_handle);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Loading FPGA from partition %s, size=%d", label, size);
+
+    rom_ctx_t rom = {
+        .data = data,
+        .size = size,
+        .pos = 0,
+    };
+
+    firmware_source_t source = {
+        .size = rom.size,
+        .ctx = &rom,
+        .read = rom_read,
+        .next_chunk = rom_next_chunk,
+    };
+
+    if (compressed || lz_header_present(rom.data, rom.size)) {
+        ret = fpga_loader_load_compressed(ctx, &source);
+    } else {
+        ret = fpga_loader_load(ctx, &source);
+    }
+
+    spi_flash_munmap(map_handle);
+
+    return ret;
+}
+
+// File source implementation
+static size_t file_read(void *buffer, size_t size, void *ctx)
+{
+    return fread(buffer, 1, size, (FILE *)ctx);
+}
+
+// Readahead file source: a background task keeps a few chunks
+// prefetched into DMA-capable buffers ahead of the transmit loop, so
+// filesystem latency (milliseconds per 2KB read on SPIFFS) is hidden
+// behind SPI transfer time instead of leaving the bus idle.
+//
+// Buffers handed out through next_chunk() may still be in the SPI
+// driver's queue, so they go through a hold-back ring of
+// LOADER_PIPELINE_DEPTH entries before being recycled to the reader:
+// by the time a later chunk is requested, the streaming loops have
+// retired the transaction that used the held-back buffer.
+
+#define READAHEAD_DEPTH 3  // Chunks kept prefetched ahead of the loop
+#define READAHEAD_BUFFERS (READAHEAD_DEPTH + LOADER_PIPELINE_DEPTH)
+
+typedef struct {
+    uint8_t *data;
+    size_t length;  // 0 marks end of stream (clean finish or read error)
+} readahead_chunk_t;
+
+typedef struct {
+    FILE *fp;
+    size_t to_read;            // Bytes the task still has to fread()
+    uint8_t *buffers;          // READAHEAD_BUFFERS chunk buffers (DMA)
+    QueueHandle_t free_bufs;   // uint8_t *: buffers the task may fill
+    QueueHandle_t ready;       // readahead_chunk_t: filled, in file order
+    SemaphoreHandle_t task_exited;
+    readahead_chunk_t current;  // Chunk being consumed
+    size_t current_pos;
+    uint8_t *held[LOADER_PIPELINE_DEPTH];  // Hold-back before recycling
+    int held_next;
+} readahead_ctx_t;
+
+static void readahead_task(void *arg)
+{
+    readahead_ctx_t *ra = (readahead_ctx_t *)arg;
+
+    while (ra->to_read > 0) {
+        uint8_t *buf;
+        xQueueReceive(ra->free_bufs, &buf, portMAX_DELAY);
+
+        size_t want = (ra->to_read > LOADER_BUFFER_SIZE) ? LOADER_BUFFER_SIZE
+                                                         : ra->to_read;
+        size_t got = fread(buf, 1, want, ra->fp);
+
+        readahead_chunk_t chunk = {.data = buf, .length = got};
+        xQueueSend(ra->ready, &chunk, portMAX_DELAY);
+
+        if (got != want) {
+            ESP_LOGE(TAG, "File read error: expected %d, got %d", want, got);
+            break;
+        }
+        ra->to_read -= got;
+    }
+
+    readahead_chunk_t end = {0};
+    xQueueSend(ra->ready, &end, portMAX_DELAY);
+    xSemaphoreGive(ra->task_exited);
+    vTaskDelete(NULL);
+}
+
+// Move to the next prefetched chunk, retiring the old one through the
+// hold-back ring. Returns false at end of stream.
+static bool readahead_advance(readahead_ctx_t *ra)
+{
+    if (ra->current.data != NULL) {
+        uint8_t **slot = &ra->held[ra->held_next];
+        if (*slot != NULL) {
+            xQueueSend(ra->free_bufs, slot, portMAX_DELAY);
+        }
+        *slot = ra->current.data;
+        ra->held_next = (ra->held_next + 1) % LOADER_PIPELINE_DEPTH;
+        ra->current.data = NULL;
+    }
+
+    readahead_chunk_t chunk;
+    xQueueReceive(ra->ready, &chunk, portMAX_DELAY);
+    if (chunk.length == 0) {
+        return false;
+    }
+
+    ra->current = chunk;
+    ra->current_pos = 0;
+    return true;
+}
+
+static size_t readahead_read(void *buffer, size_t size, void *vctx)
+{
+    readahead_ctx_t *ra = (readahead_ctx_t *)vctx;
+    uint8_t *out = (uint8_t *)buffer;
+    size_t copied = 0;
+
+    while (copied < size) {
+        if (ra->current_pos >= ra->current.length) {
+            if (!readahead_advance(ra)) {
+                break;
+            }
+        }
+        size_t avail = ra->current.length - ra->current_pos;
+        size_t take = size - copied;
+        if (take > avail) {
+            take = avail;
+        }
+        memcpy(out + copied, ra->current.data + ra->current_pos, take);
+        copied += take;
+        ra->current_pos += take;
+    }
+    return copied;
+}
+
+static const uint8_t *readahead_next_chunk(size_t max_size, size_t *out_size, void *vctx)
+{
+    readahead_ctx_t *ra = (readahead_ctx_t *)vctx;
+
+    if (ra->current_pos >= ra->current.length) {
+        if (!readahead_advance(ra)) {
+            return NULL;
+        }
+    }
+
+    size_t avail = ra->current.length - ra->current_pos;
+    const uint8_t *ptr = ra->current.data + ra->current_pos;
+    *out_size = (avail < max_size) ? avail : max_size;
+    ra->current_pos += *out_size;
+    return ptr;
+}
+
+// Start the prefetcher; returns false (with everything cleaned up) if
+// buffers or the task can't be allocated, in which case the caller
+// falls back to the synchronous source
+static bool readahead_start(readahead_ctx_t *ra, FILE *fp, size_t size)
+{
+    memset(ra, 0, sizeof(*ra));
+    ra->fp = fp;
+    ra->to_read = size;
+    ra->buffers = heap_caps_malloc(LOADER_BUFFER_SIZE * READAHEAD_BUFFERS, MALLOC_CAP_DMA);
+    ra->free_bufs = xQueueCreate(READAHEAD_BUFFERS, sizeof(uint8_t *));
+    ra->ready = xQueueCreate(READAHEAD_BUFFERS, sizeof(readahead_chunk_t));
+    ra->task_exited = xSemaphoreCreateBinary();
+
+    bool ok = ra->buffers != NULL && ra->free_bufs != NULL &&
+              ra->ready != NULL && ra->task_exited != NULL;
+    if (ok) {
+        for (int i = 0; i < READAHEAD_BUFFERS; i++) {
+            uint8_t *buf = ra->buffers + (i * LOADER_BUFFER_SIZE);
+            xQueueSend(ra->free_bufs, &buf, portMAX_DELAY);
+        }
+        ok = xTaskCreate(readahead_task, "fpga_fetch", 3072, ra, 10, NULL) == pdPASS;
+    }
+
+    if (!ok) {
+        ESP_LOGW(TAG, "Readahead unavailable, reading file synchronously");
+        if (ra->free_bufs != NULL) {
+            vQueueDelete(ra->free_bufs);
+        }
+        if (ra->ready != NULL) {
+            vQueueDelete(ra->ready);
+        }
+        if (ra->task_exited != NULL) {
+            vSemaphoreDelete(ra->task_exited);
+        }
+        heap_caps_free(ra->buffers);
+    }
+    return ok;
+}
+
+// Unblock the prefetcher if the load stopped early, wait for it to
+// exit, and free everything
+static void readahead_stop(readahead_ctx_t *ra)
+{
+    for (int i = 0; i < LOADER_PIPELINE_DEPTH; i++) {
+        if (ra->held[i] != NULL) {
+            xQueueSend(ra->free_bufs, &ra->held[i], portMAX_DELAY);
+        }
+    }
+    if (ra->current.data != NULL) {
+        xQueueSend(ra->free_bufs, &ra->current.data, portMAX_DELAY);
+    }
+
+    readahead_chunk_t chunk;
+    do {
+        xQueueReceive(ra->ready, &chunk, portMAX_DELAY);
+        if (chunk.length > 0) {
+            xQueueSend(ra->free_bufs, &chunk.data, portMAX_DELAY);
+        }
+    } while (chunk.length > 0);
+
+    xSemaphoreTake(ra->task_exited, portMAX_DELAY);
+
+    vSemaphoreDelete(ra->task_exited);
+    vQueueDelete(ra->free_bufs);
+    vQueueDelete(ra->ready);
+    heap_caps_free(ra->buffers);
+}
+
+esp_err_t fpga_loader_ctx_load_from_file(fpga_loader_ctx_t *ctx, const char *filename)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        ESP_LOGE(TAG, "File not found: %s", filename);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // A leading AFBS container header gives the payload size and
+    // compression flag directly; bare images seek for the size and
+    // sniff the AFLZ magic instead
+    fpga_image_header_t header;
+    size_t got = fread(&header, 1, sizeof(header), fp);
+
+    size_t size;
+    bool compressed;
+    bool has_crc = false;
+    if (got == sizeof(header) && memcmp(header.magic, FPGA_IMAGE_MAGIC, 4) == 0) {
+        size = header.length;
+        compressed = (header.flags & FPGA_IMAGE_FLAG_COMPRESSED) != 0;
+        has_crc = true;
+    } else {
+        fseek(fp, 0, SEEK_END);
+        long end = ftell(fp);
+        if (end < 0) {
+            ESP_LOGE(TAG, "Failed to size: %s", filename);
+            fclose(fp);
+            return ESP_FAIL;
+        }
+        size = end;
+        compressed = lz_header_present((const uint8_t *)&header, got);
+        fseek(fp, 0, SEEK_SET);
+    }
+
+    ESP_LOGI(TAG, "Loading FPGA from %s, size=%d", filename, size);
+
+    // Prefetch chunks in the background so VFS latency overlaps with
+    // SPI clocking; fall back to synchronous reads if that can't start
+    readahead_ctx_t ra;
+    bool readahead = readahead_start(&ra, fp, size);
+
+    firmware_source_t source = {
+        .size = size,
+        .ctx = readahead ? (void *)&ra : (void *)fp,
+        .read = readahead ? readahead_read : file_read,
+        .next_chunk = readahead ? readahead_next_chunk : NULL,
+    };
+
+    // AFBS images get their payload CRC verified incrementally as it
+    // streams; checking it up front would mean reading the file twice
+    // and defeat the readahead
+    crc_ctx_t cc;
+    firmware_source_t crc_source;
+    firmware_source_t *load_source = &source;
+    if (has_crc) {
+        crc_source_wrap(&crc_source, &source, &cc, header.crc32);
+        load_source = &crc_source;
+    }
+
+    esp_err_t ret;
+    if (compressed) {
+        ret = fpga_loader_load_compressed(ctx, load_source);
+    } else {
+        ret = fpga_loader_load(ctx, load_source);
+    }
+
+    if (readahead) {
+        readahead_stop(&ra);
+    }
+    fclose(fp);
+
+    return ret;
+}
+
+// Prepared-bitstream cache: slots in a dedicated flash partition hold
+// the load-ready form of recently seen files — decompressed,
+// header-validated, contiguous — keyed by a content hash. A hit skips
+// the container parsing, CRC pass and AFLZ decompression entirely and
+// streams like a partition load.
+//
+// Each slot starts with a commit record in its own erase sector. The
+// record is erased before a slot is rewritten and written back only
+// after the whole payload is on flash, so a power loss mid-prepare
+// leaves the slot invalid rather than pointing at a partial image.
+
+#define CACHE_SLOTS 4
+#define CACHE_SLOT_MAGIC 0x31434641  // "AFC1"
+#define CACHE_ERASE_SIZE 4096
+
+// Payload begins past the commit record at a chunk boundary, so cache
+// hits stream in whole LOADER_BUFFER_SIZE chunks from byte 0
+#define CACHE_PAYLOAD_OFFSET \
+    (((LOADER_BUFFER_SIZE > CACHE_ERASE_SIZE ? LOADER_BUFFER_SIZE : CACHE_ERASE_SIZE) + \
+      CACHE_ERASE_SIZE - 1) & ~(size_t)(CACHE_ERASE_SIZE - 1))
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;   // CACHE_SLOT_MAGIC
+    uint32_t key;     // Content hash of the source image
+    uint32_t length;  // Prepared payload bytes
+    uint32_t seq;     // Insertion counter; the lowest evicts first
+} cache_slot_header_t;
+
+static const esp_partition_t *cache_partition(size_t *out_slot_size)
+{
+    const esp_partition_t *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, FPGA_LOADER_CACHE_PARTITION);
+    if (partition == NULL) {
+        return NULL;
+    }
+
+    size_t slot_size = (partition->size / CACHE_SLOTS) & ~(size_t)(CACHE_ERASE_SIZE - 1);
+    if (slot_size <= CACHE_PAYLOAD_OFFSET) {
+        ESP_LOGW(TAG, "Cache partition too small for %d slots", CACHE_SLOTS);
+        return NULL;
+    }
+
+    *out_slot_size = slot_size;
+    return partition;
+}
+
+// Content hash of a bitstream file, plus the size of its prepared
+// (decompressed) form so slot fit can be checked before any erase
+static esp_err_t cache_file_key(const char *filename, uint32_t *out_key,
+                                size_t *out_prepared_size)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    fpga_image_header_t header;
+    size_t got = fread(&header, 1, sizeof(header), fp);
+
+    esp_err_t ret = ESP_OK;
+    if (got == sizeof(header) && memcmp(header.magic, FPGA_IMAGE_MAGIC, 4) == 0) {
+        // The packed payload CRC is already a content hash, so AFBS
+        // images get their cache key from the header for free
+        *out_key = header.crc32;
+        if ((header.flags & FPGA_IMAGE_FLAG_COMPRESSED) != 0) {
+            lz_header_t lz;
+            if (fread(&lz, 1, sizeof(lz), fp) == sizeof(lz) &&
+                memcmp(lz.magic, LZ_MAGIC, 4) == 0) {
+                *out_prepared_size = lz.raw_size;
+            } else {
+                ret = ESP_ERR_INVALID_ARG;
+            }
+        } else {
+            *out_prepared_size = header.length;
+        }
+    } else {
+        // Bare images carry no trustworthy metadata: hash the whole
+        // file (one extra sequential read on every lookup)
+        bool compressed = lz_header_present((const uint8_t *)&header, got);
+        uint32_t raw_size = 0;
+        if (compressed) {
+            memcpy(&raw_size, (const uint8_t *)&header + 4, sizeof(raw_size));
+        }
+
+        uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&header, got);
+        size_t total = got;
+        uint8_t buf[256];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+            crc = esp_rom_crc32_le(crc, buf, n);
+            total += n;
+        }
+
+        *out_key = crc;
+        *out_prepared_size = compressed ? raw_size : total;
+    }
+
+    fclose(fp);
+    return ret;
+}
+
+static int cache_lookup(const esp_partition_t *partition, size_t slot_size,
+                        uint32_t key, uint32_t *out_length)
+{
+    for (int i = 0; i < CACHE_SLOTS; i++) {
+        cache_slot_header_t header;
+        if (esp_partition_read(partition, (size_t)i * slot_size,
+                               &header, sizeof(header)) != ESP_OK) {
+            continue;
+        }
+        if (header.magic == CACHE_SLOT_MAGIC && header.key == key) {
+            *out_length = header.length;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Empty slots first, then the slot inserted longest ago
+static int cache_pick_victim(const esp_partition_t *partition, size_t slot_size,
+                             uint32_t *out_seq)
+{
+    int victim = 0;
+    uint32_t victim_seq = UINT32_MAX;
+    uint32_t next_seq = 1;
+
+    for (int i = 0; i < CACHE_SLOTS; i++) {
+        cache_slot_header_t header;
+        if (esp_partition_read(partition, (size_t)i * slot_size,
+                               &header, sizeof(header)) != ESP_OK ||
+            header.magic != CACHE_SLOT_MAGIC) {
+            header.seq = 0;  // Empty beats any valid entry
+        } else if (header.seq >= next_seq) {
+            next_seq = header.seq + 1;
+        }
+        if (header.seq < victim_seq) {
+            victim = i;
+            victim_seq = header.seq;
+        }
+    }
+
+    *out_seq = next_seq;
+    return victim;
+}
+
+static esp_err_t cache_load_hit(fpga_loader_ctx_t *ctx, const esp_partition_t *partition,
+                                size_t slot_size, int slot, uint32_t length)
+{
+    const void *mapped;
+    spi_flash_mmap_handle_t map_handle;
+    esp_err_t ret = esp_partition_mmap(partition,
+                                       (size_t)slot * slot_size + CACHE_PAYLOAD_OFFSET,
+                                       length, SPI_FLASH_MMAP_DATA, &mapped, &map_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map cache slot %d: %s", slot, esp_err_to_name(ret));
+        return ret;
+    }
+
+    rom_ctx_t rom = {
+        .data = mapped,
+        .size = length,
+        .pos = 0,
+    };
+
+    firmware_source_t source = {
+        .size = rom.size,
+        .ctx = &rom,
+        .read = rom_read,
+        .next_chunk = rom_next_chunk,
+    };
+
+    ret = fpga_loader_load(ctx, &source);
+
+    spi_flash_munmap(map_handle);
+
+    return ret;
+}
+
+// Re-walk the source file the way the load just did, writing the
+// decompressed payload to the slot instead of the FPGA
+static esp_err_t cache_prepare(const esp_partition_t *partition, size_t slot_size,
+                               int slot, uint32_t key, uint32_t seq,
+                               const char *filename, size_t prepared_size)
+{
+    size_t slot_offset = (size_t)slot * slot_size;
+
+    // Invalidate the slot before touching its payload (see above)
+    esp_err_t ret = esp_partition_erase_range(partition, slot_offset, CACHE_ERASE_SIZE);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    size_t erase_bytes = (prepared_size + CACHE_ERASE_SIZE - 1) &
+                         ~(size_t)(CACHE_ERASE_SIZE - 1);
+    ret = esp_partition_erase_range(partition, slot_offset + CACHE_PAYLOAD_OFFSET,
+                                    erase_bytes);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    fpga_image_header_t header;
+    size_t got = fread(&header, 1, sizeof(header), fp);
+
+    size_t size;
+    bool compressed;
+    if (got == sizeof(header) && memcmp(header.magic, FPGA_IMAGE_MAGIC, 4) == 0) {
+        size = header.length;
+        compressed = (header.flags & FPGA_IMAGE_FLAG_COMPRESSED) != 0;
+    } else {
+        fseek(fp, 0, SEEK_END);
+        long end = ftell(fp);
+        if (end < 0) {
+            fclose(fp);
+            return ESP_FAIL;
+        }
+        size = end;
+        compressed = lz_header_present((const uint8_t *)&header, got);
+        fseek(fp, 0, SEEK_SET);
+    }
+
+    firmware_source_t file_source = {
+        .size = size,
+        .ctx = fp,
+        .read = file_read,
+    };
+
+    lz_ctx_t *lz = NULL;
+    firmware_source_t lz_source;
+    firmware_source_t *source = &file_source;
+    if (compressed) {
+        lz_header_t lz_header;
+        if (file_read(&lz_header, sizeof(lz_header), fp) != sizeof(lz_header) ||
+            memcmp(lz_header.magic, LZ_MAGIC, 4) != 0) {
+            fclose(fp);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        lz = heap_caps_calloc(1, sizeof(lz_ctx_t), MALLOC_CAP_DEFAULT);
+        if (lz == NULL) {
+            fclose(fp);
+            return ESP_ERR_NO_MEM;
+        }
+        lz->inner = &file_source;
+        lz->in_remaining = size - sizeof(lz_header);
+
+        lz_source = (firmware_source_t){
+            .size = lz_header.raw_size,
+            .ctx = lz,
+            .read = lz_read,
+        };
+        source = &lz_source;
+    }
+
+    uint8_t *buffer = malloc(CACHE_ERASE_SIZE);
+    size_t written = 0;
+    if (buffer == NULL) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        while (written < source->size) {
+            size_t want = source->size - written;
+            if (want > CACHE_ERASE_SIZE) {
+                want = CACHE_ERASE_SIZE;
+            }
+            size_t n = source->read(buffer, want, source->ctx);
+            if (n == 0) {
+                ret = ESP_FAIL;
+                break;
+            }
+            ret = esp_partition_write(partition,
+                                      slot_offset + CACHE_PAYLOAD_OFFSET + written,
+                                      buffer, n);
+            if (ret != ESP_OK) {
+                break;
+            }
+            written += n;
+        }
+    }
+
+    free(buffer);
+    heap_caps_free(lz);
+    fclose(fp);
+
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (written != prepared_size) {
+        return ESP_FAIL;
+    }
+
+    // Payload complete: the commit record makes the slot visible
+    cache_slot_header_t slot_header = {
+        .magic = CACHE_SLOT_MAGIC,
+        .key = key,
+        .length = written,
+        .seq = seq,
+    };
+    return esp_partition_write(partition, slot_offset, &slot_header, sizeof(slot_header));
+}
+
+esp_err_t fpga_loader_ctx_load_from_file_cached(fpga_loader_ctx_t *ctx, const char *filename)
+{
+    size_t slot_size;
+    const esp_partition_t *partition = cache_partition(&slot_size);
+    if (partition == NULL) {
+        // No usable cache partition in the table: behave exactly like
+        // the uncached call
+        return fpga_loader_ctx_load_from_file(ctx, filename);
+    }
+
+    uint32_t key;
+    size_t prepared_size;
+    esp_err_t ret = cache_file_key(filename, &key, &prepared_size);
+    if (ret != ESP_OK) {
+        // Unreadable or malformed: the plain path reports it as usual
+        return fpga_loader_ctx_load_from_file(ctx, filename);
+    }
+
+    uint32_t length;
+    int slot = cache_lookup(partition, slot_size, key, &length);
+    if (slot >= 0 && length == prepared_size) {
+        ESP_LOGI(TAG, "Cache hit for %s (key %08x), streaming prepared image",
+                 filename, key);
+        return cache_load_hit(ctx, partition, slot_size, slot, length);
+    }
+
+    ret = fpga_loader_ctx_load_from_file(ctx, filename);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // First sighting and the load checked out: write the prepared copy
+    // so the next load of this content skips all preprocessing
+    if (prepared_size > slot_size - CACHE_PAYLOAD_OFFSET) {
+        ESP_LOGW(TAG, "Prepared image (%d bytes) exceeds cache slot, not caching",
+                 prepared_size);
+        return ESP_OK;
+    }
+
+    uint32_t seq;
+    slot = cache_pick_victim(partition, slot_size, &seq);
+    esp_err_t cache_ret = cache_prepare(partition, slot_size, slot, key, seq,
+                                        filename, prepared_size);
+    if (cache_ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to cache prepared bitstream: %s",
+                 esp_err_to_name(cache_ret));
+    } else {
+        ESP_LOGI(TAG, "Cached prepared bitstream in slot %d (%d bytes, key %08x)",
+                 slot, prepared_size, key);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t fpga_loader_ctx_load_from_frags(fpga_loader_ctx_t *ctx,
+                                          const fpga_loader_frag_t *frags, size_t count)
+{
+    if (frags == NULL || count == 0) {
+        ESP_LOGE(TAG, "Invalid fragment list");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (frags[i].data == NULL && frags[i].size > 0) {
+            ESP_LOGE(TAG, "Invalid fragment list");
+            return ESP_ERR_INVALID_ARG;
+        }
+        total += frags[i].size;
+    }
+    if (total == 0) {
+        ESP_LOGE(TAG, "Empty fragment list");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    frag_ctx_t fc = {
+        .frags = frags,
+        .count = count,
+    };
+
+    ESP_LOGI(TAG, "Loading FPGA from %d fragments, size=%d", count, total);
+
+    firmware_source_t source = {
+        .size = total,
+        .ctx = &fc,
+        .read = frag_read,
+        .next_chunk = frag_next_chunk,
+    };
+
+    // Probe for the compressed container magic (it may straddle a
+    // fragment boundary), then rewind
+    uint8_t probe[sizeof(lz_header_t)];
+    size_t probed = frag_read(probe, sizeof(probe), &fc);
+    fc.index = 0;
+    fc.offset = 0;
+
+    if (lz_header_present(probe, probed)) {
+        return fpga_loader_load_compressed(ctx, &source);
+    }
+    return fpga_loader_load(ctx, &source);
+}
+
+// Interleaved dual-FPGA load. Boards with two ICE40s share SCLK/MOSI but
+// have per-device CS/CRESET/CDONE; chunks for the two bitstreams are
+// alternated on the wire, with CS steering each chunk to its device (the
+// ICE40 ignores configuration clocks while its SS is high). While one
+// device's chunk is clocking out, the other device's next chunk is read
+// and decompressed, so the source side of both loads is fully hidden.
+
+typedef struct {
+    fpga_loader_ctx_t *ctx;
+    firmware_source_t *source;
+    size_t remaining;
+    // Source plumbing owned by interleave_source_open()
+    rom_ctx_t rom;
+    firmware_source_t rom_source;
+    firmware_source_t lz_source;
+    lz_ctx_t *lz;
+} interleave_dev_t;
+
+static esp_err_t interleave_source_open(interleave_dev_t *dev, const fpga_bin_t *bin)
+{
+    if (bin == NULL || bin->end <= bin->start) {
+        ESP_LOGE(TAG, "Invalid FPGA binary");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    dev->rom = (rom_ctx_t){
+        .data = bin->start,
+        .size = bin->end - bin->start,
+    };
+    dev->rom_source = (firmware_source_t){
+        .size = dev->rom.size,
+        .ctx = &dev->rom,
+        .read = rom_read,
+        .next_chunk = rom_next_chunk,
+    };
+    dev->source = &dev->rom_source;
+
+    if (lz_header_present(dev->rom.data, dev->rom.size)) {
+        lz_header_t header;
+        rom_read(&header, sizeof(header), &dev->rom);
+
+        dev->lz = heap_caps_calloc(1, sizeof(lz_ctx_t), MALLOC_CAP_DEFAULT);
+        if (dev->lz == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate decompressor context");
+            return ESP_ERR_NO_MEM;
+        }
+        dev->lz->inner = &dev->rom_source;
+        dev->lz->in_remaining = dev->rom.size - sizeof(header);
+
+        dev->lz_source = (firmware_source_t){
+            .size = header.raw_size,
+            .ctx = dev->lz,
+            .read = lz_read,
+        };
+        dev->source = &dev->lz_source;
+    }
+
+    dev->remaining = dev->source->size;
+    return ESP_OK;
+}
+
+// Alternate chunks between the two devices, keeping one transaction in
+// flight while the other device's chunk is filled
+static esp_err_t stream_interleaved(interleave_dev_t *devs)
+{
+    spi_device_handle_t bus_dev = devs[0].ctx->dev.device;
+    spi_transaction_t trans;
+    int inflight = -1;  // Index of the device whose chunk is on the wire
+    int turn = 0;
+    esp_err_t ret = ESP_OK;
+
+    while (devs[0].remaining > 0 || devs[1].remaining > 0) {
+        if (devs[turn].remaining == 0) {
+            turn ^= 1;
+        }
+        interleave_dev_t *d = &devs[turn];
+
+        // Fill this device's chunk while the other's is still clocking
+        size_t chunk = (d->remaining > d->ctx->chunk_size) ? d->ctx->chunk_size
+                                                           : d->remaining;
+        const uint8_t *tx_buffer;
+        ret = source_fill_chunk(d->source, d->ctx->buffer, &chunk, &tx_buffer);
+        if (ret != ESP_OK) {
+            break;
+        }
+
+        if (inflight >= 0) {
+            spi_transaction_t *completed;
+            ret = spi_device_get_trans_result(bus_dev, &completed, portMAX_DELAY);
+            gpio_set_level(devs[inflight].ctx->dev.cs_gpio, 1);
+            inflight = -1;
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Transmit error: %s", esp_err_to_name(ret));
+                break;
+            }
+        }
+
+        gpio_set_level(d->ctx->dev.cs_gpio, 0);
+        memset(&trans, 0, sizeof(spi_transaction_t));
+        trans.length = chunk * 8;
+        trans.tx_buffer = tx_buffer;
+
+        ret = spi_device_queue_trans(bus_dev, &trans, portMAX_DELAY);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Write error: %s", esp_err_to_name(ret));
+            gpio_set_level(d->ctx->dev.cs_gpio, 1);
+            break;
+        }
+
+        inflight = turn;
+        d->remaining -= chunk;
+        turn ^= 1;
+    }
+
+    if (inflight >= 0) {
+        spi_transaction_t *completed;
+        spi_device_get_trans_result(bus_dev, &completed, portMAX_DELAY);
+        gpio_set_level(devs[inflight].ctx->dev.cs_gpio, 1);
+    }
+
+    return ret;
+}
+
+esp_err_t fpga_loader_load_from_rom_interleaved(fpga_loader_ctx_t *ctx_a,
+                                                const fpga_bin_t *bin_a,
+                                                fpga_loader_ctx_t *ctx_b,
+                                                const fpga_bin_t *bin_b)
+{
+    if (ctx_a == NULL || ctx_b == NULL || ctx_a == ctx_b) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    interleave_dev_t devs[2] = {
+        {.ctx = ctx_a},
+        {.ctx = ctx_b},
+    };
+
+    esp_err_t ret = interleave_source_open(&devs[0], bin_a);
+    if (ret == ESP_OK) {
+        ret = interleave_source_open(&devs[1], bin_b);
+    }
+    if (ret != ESP_OK) {
+        goto cleanup_sources;
+    }
+
+    loaded_image_invalidate();
+
+    // All clocking goes through device A's SPI handle; CS GPIOs steer it
+    ret = spi_device_acquire_bus(ctx_a->dev.device, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to acquire SPI bus: %s", esp_err_to_name(ret));
+        goto cleanup_sources;
+    }
+
+    ESP_LOGI(TAG, "Interleaved load: %d + %d bytes",
+             devs[0].remaining, devs[1].remaining);
+    int64_t t_start = esp_timer_get_time();
+
+    // Reset handshake (TN1248 steps 1-6), run on both devices together
+    for (int i = 0; i < 2; i++) {
+        reset_pin_set(&devs[i].ctx->dev, 0);
+        gpio_set_level(devs[i].ctx->dev.cs_gpio, 0);
+        gpio_matrix_out(devs[i].ctx->dev.cs_gpio, SIG_GPIO_OUT_IDX, false, false);
+    }
+    esp_rom_delay_us(1);
+    for (int i = 0; i < 2; i++) {
+        reset_pin_set(&devs[i].ctx->dev, 1);
+    }
+    esp_rom_delay_us(1300);
+    for (int i = 0; i < 2; i++) {
+        gpio_set_level(devs[i].ctx->dev.cs_gpio, 1);
+    }
+    {
+        // Shared dummy clocks: both devices see them with SS high
+        uint8_t dummy[1] = {0};
+        ret = write_update_block(ctx_a->dev.device, dummy, sizeof(dummy));
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to send dummy clocks");
+            goto cleanup_bus;
+        }
+    }
+
+    // Step 7: alternate bitstream chunks between the devices
+    ret = stream_interleaved(devs);
+
+    // Steps 8-9: the post-bitstream clock trains go out once with both
+    // SS high; check each device's CDONE in between
+    memset(ctx_a->buffer, 0, LOADER_BUFFER_SIZE);
+    write_update_block(ctx_a->dev.device, ctx_a->buffer, 13);  // 104 clocks
+
+    for (int i = 0; i < 2; i++) {
+        esp_err_t cdone_ret = cdone_pin_wait(&devs[i].ctx->dev, true, 100);
+        if (cdone_ret != ESP_OK) {
+            ESP_LOGE(TAG, "CDONE timeout on CS=%d - configuration failed",
+                     devs[i].ctx->dev.cs_gpio);
+            ret = cdone_ret;
+        }
+    }
+
+    write_update_block(ctx_a->dev.device, ctx_a->buffer, 7);  // 56 clocks
+
+    // Step 10: hand CS back on both devices
+    for (int i = 0; i < 2; i++) {
+        cs_pin_restore(&devs[i].ctx->dev);
+    }
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Interleaved configuration complete in %lld us",
+                 esp_timer_get_time() - t_start);
+    }
+
+cleanup_bus:
+    spi_device_release_bus(ctx_a->dev.device);
+
+cleanup_sources:
+    heap_caps_free(devs[0].lz);
+    heap_caps_free(devs[1].lz);
+
+    return ret;
+}
+
+// Streaming source implementation: a producer task (typically an
+// esp_http_client event handler) feeds bytes into a ring buffer while a
+// consumer task clocks them into the FPGA, so network receive and SPI
+// programming overlap instead of running back to back.
+
+#define STREAM_RING_SIZE (LOADER_BUFFER_SIZE * 4)
+#define STREAM_POLL_MS 100
+
+struct fpga_loader_stream {
+    fpga_loader_ctx_t *ctx;
+    StreamBufferHandle_t ring;
+    SemaphoreHandle_t done;        // Given by the consumer task on exit
+    esp_err_t result;
+    size_t size;                   // Declared payload size (as transferred)
+    volatile bool finished;        // Producer promises no further writes
+    // First bytes of the payload, captured for container detection and
+    // replayed ahead of the ring
+    uint8_t probe[sizeof(lz_header_t)];
+    size_t probe_len;
+    size_t probe_pos;
+};
+
+static size_t stream_source_read(void *buffer, size_t size, void *vctx)
+{
+    fpga_loader_stream_t *stream = (fpga_loader_stream_t *)vctx;
+    uint8_t *out = (uint8_t *)buffer;
+    size_t got = 0;
+
+    // Replay the container-detection probe before draining the ring
+    while (got < size && stream->probe_pos < stream->probe_len) {
+        out[got++] = stream->probe[stream->probe_pos++];
+    }
+
+    while (got < size) {
+        size_t r = xStreamBufferReceive(stream->ring, out + got, size - got,
+                                        pdMS_TO_TICKS(STREAM_POLL_MS));
+        got += r;
+        if (r == 0 && stream->finished &&
+            xStreamBufferIsEmpty(stream->ring) == pdTRUE) {
+            break;  // Producer is done and under-delivered
+        }
+    }
+    return got;
+}
+
+static void stream_consumer_task(void *arg)
+{
+    fpga_loader_stream_t *stream = (fpga_loader_stream_t *)arg;
+
+    // Capture enough of the payload to detect the AFLZ container
+    size_t want = sizeof(stream->probe);
+    if (want > stream->size) {
+        want = stream->size;
+    }
+    while (stream->probe_len < want) {
+        size_t r = xStreamBufferReceive(stream->ring,
+                                        stream->probe + stream->probe_len,
+                                        want - stream->probe_len,
+                                        pdMS_TO_TICKS(STREAM_POLL_MS));
+        stream->probe_len += r;
+        if (r == 0 && stream->finished &&
+            xStreamBufferIsEmpty(stream->ring) == pdTRUE) {
+            break;
+        }
+    }
+
+    firmware_source_t source = {
+        .size = stream->size,
+        .ctx = stream,
+        .read = stream_source_read,
+    };
+
+    if (lz_header_present(stream->probe, stream->probe_len)) {
+        stream->result = fpga_loader_load_compressed(stream->ctx, &source);
+    } else {
+        stream->result = fpga_loader_load(stream->ctx, &source);
+    }
+
+    xSemaphoreGive(stream->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t fpga_loader_stream_begin(size_t size, fpga_loader_stream_t **out_stream)
+{
+    if (size == 0 || out_stream == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fpga_loader_stream_t *stream = calloc(1, sizeof(fpga_loader_stream_t));
+    if (stream == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    stream->size = size;
+    stream->result = ESP_FAIL;
+
+    stream->ring = xStreamBufferCreate(STREAM_RING_SIZE, 1);
+    stream->done = xSemaphoreCreateBinary();
+    if (stream->ring == NULL || stream->done == NULL) {
+        goto fail;
+    }
+
+    esp_err_t ret = fpga_loader_ctx_init(&stream->ctx);
+    if (ret != ESP_OK) {
+        goto fail;
+    }
+
+    ESP_LOGI(TAG, "Streaming load started, size=%d", size);
+
+    if (xTaskCreate(stream_consumer_task, "fpga_stream", 4096, stream, 10,
+                    NULL) != pdPASS) {
+        fpga_loader_ctx_deinit(stream->ctx);
+        goto fail;
+    }
+
+    *out_stream = stream;
+    return ESP_OK;
+
+fail:
+    if (stream->ring != NULL) {
+        vStreamBufferDelete(stream->ring);
+    }
+    if (stream->done != NULL) {
+        vSemaphoreDelete(stream->done);
+    }
+    free(stream);
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t fpga_loader_stream_write(fpga_loader_stream_t *stream,
+                                   const void *data, size_t size)
+{
+    if (stream == NULL || stream->finished) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const uint8_t *bytes = (const uint8_t *)data;
+    size_t sent = 0;
+
+    while (sent < size) {
+        size_t s = xStreamBufferSend(stream->ring, bytes + sent, size - sent,
+                                     pdMS_TO_TICKS(1000));
+        sent += s;
+        if (s == 0 && xSemaphoreTake(stream->done, 0) == pdTRUE) {
+            // Consumer bailed out (load error); stop the producer early
+            xSemaphoreGive(stream->done);
+            return (stream->result == ESP_OK) ? ESP_FAIL : stream->result;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t fpga_loader_stream_finish(fpga_loader_stream_t *stream)
+{
+    if (stream == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Unblocks the consumer if fewer than the declared bytes arrived
+    stream->finished = true;
+
+    xSemaphoreTake(stream->done, portMAX_DELAY);
+    esp_err_t ret = stream->result;
+
+    fpga_loader_ctx_deinit(stream->ctx);
+    vStreamBufferDelete(stream->ring);
+    vSemaphoreDelete(stream->done);
+    free(stream);
+
+    return ret;
+}
+
+// Full load/CDONE round trip at a trial frequency
+static esp_err_t calibrate_trial(const fpga_bin_t *fpga_bin, int freq)
+{
+    freq_override_mhz = freq;
+
+    fpga_loader_ctx_t *ctx;
+    esp_err_t ret = fpga_loader_ctx_init(&ctx);
+    if (ret == ESP_OK) {
+        ret = fpga_loader_ctx_load_from_rom(ctx, fpga_bin);
+        fpga_loader_ctx_deinit(ctx);
+    }
+
+    freq_override_mhz = 0;
+    return ret;
+}
+
+esp_err_t fpga_loader_calibrate(const fpga_bin_t *fpga_bin, int *out_freq_mhz)
+{
+    int lo = CONFIG_FPGA_SPI_FREQ_PROGRAMMING;
+    int hi = LOADER_MAX_PROG_FREQ_MHZ + 1;
+
+    // The configured frequency is the assumed-reliable floor
+    if (calibrate_trial(fpga_bin, lo) != ESP_OK) {
+        ESP_LOGE(TAG, "Load failed at the configured %d MHz; not calibrating", lo);
+        return ESP_FAIL;
+    }
+
+    // Bisect for the highest frequency that still configures cleanly
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (calibrate_trial(fpga_bin, mid) == ESP_OK) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Confirm, stepping down if the passing point was marginal
+    while (lo > CONFIG_FPGA_SPI_FREQ_PROGRAMMING &&
+           calibrate_trial(fpga_bin, lo) != ESP_OK) {
+        lo--;
+    }
+
+    ESP_LOGI(TAG, "Calibrated programming frequency: %d MHz", lo);
+
+    calibrated_freq_mhz = lo;
+    calibrated_freq_checked = true;
+
+    // Persist per-board; best effort (the application owns NVS init)
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(LOADER_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret == ESP_OK) {
+        ret = nvs_set_i32(nvs, LOADER_NVS_KEY_PROG_FREQ, lo);
+        if (ret == ESP_OK) {
+            ret = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to persist calibration: %s", esp_err_to_name(ret));
+    }
+
+    if (out_freq_mhz != NULL) {
+        *out_freq_mhz = lo;
+    }
+    return ESP_OK;
+}
+
+esp_err_t fpga_loader_load_from_rom_if_needed(const fpga_bin_t *fpga_bin)
+{
+    if (fpga_bin == NULL || fpga_bin->end <= fpga_bin->start) {
+        ESP_LOGE(TAG, "Invalid FPGA binary");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t crc = esp_rom_crc32_le(0, fpga_bin->start,
+                                    fpga_bin->end - fpga_bin->start);
+
+    // CDONE proves *a* configuration is live; the RTC record proves it
+    // was this image
+    if (gpio_get_level(default_dev.cdone_gpio) == 1 && loaded_image_matches(crc)) {
+        ESP_LOGI(TAG, "FPGA already configured with this bitstream, skipping reload");
+        return ESP_OK;
+    }
+
+    esp_err_t ret = fpga_loader_load_from_rom(fpga_bin);
+    if (ret == ESP_OK) {
+        loaded_image_store(crc);
+    }
+    return ret;
+}
+
+// One-shot wrappers: a transient context keeps the legacy API working for
+// callers that load once at boot and never again
+
+esp_err_t fpga_loader_load_from_rom(const fpga_bin_t *fpga_bin)
+{
+    fpga_loader_ctx_t *ctx;
+    esp_err_t ret = fpga_loader_ctx_init(&ctx);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = fpga_loader_ctx_load_from_rom(ctx, fpga_bin);
+    fpga_loader_ctx_deinit(ctx);
+    return ret;
+}
+
+esp_err_t fpga_loader_load_from_file(const char *filename)
+{
+    fpga_loader_ctx_t *ctx;
+    esp_err_t ret = fpga_loader_ctx_init(&ctx);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = fpga_loader_ctx_load_from_file(ctx, filename);
+    fpga_loader_ctx_deinit(ctx);
+    return ret;
+}
+
+esp_err_t fpga_loader_load_from_file_cached(const char *filename)
+{
+    fpga_loader_ctx_t *ctx;
+    esp_err_t ret = fpga_loader_ctx_init(&ctx);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = fpga_loader_ctx_load_from_file_cached(ctx, filename);
+    fpga_loader_ctx_deinit(ctx);
+    return ret;
+}
+
+esp_err_t fpga_loader_load_from_partition(const char *label, size_t size)
+{
+    fpga_loader_ctx_t *ctx;
+    esp_err_t ret = fpga_loader_ctx_init(&ctx);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = fpga_loader_ctx_load_from_partition(ctx, label, size);
+    fpga_loader_ctx_deinit(ctx);
+    return ret;
+}
+
+esp_err_t fpga_loader_load_from_frags(const fpga_loader_frag_t *frags, size_t count)
+{
+    fpga_loader_ctx_t *ctx;
+    esp_err_t ret = fpga_loader_ctx_init(&ctx);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = fpga_loader_ctx_load_from_frags(ctx, frags, count);
+    fpga_loader_ctx_deinit(ctx);
+    return ret;
+}
+
+esp_err_t fpga_loader_dev_init(const fpga_dev_t *dev)
+{
+    // Configure CRESET as output (active low)
+    gpio_config_t creset_cfg = {
+        .pin_bit_mask = (1ULL << dev->creset_gpio),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
     };
-    gpio_set_level(CONFIG_FPGA_CRESET_GPIO, 0);
+    gpio_set_level(dev->creset_gpio, 0);
     gpio_config(&creset_cfg);
 
     // Configure CDONE as input
     gpio_config_t cdone_cfg = {
-        .pin_bit_mask = (1ULL << CONFIG_FPGA_CDONE_GPIO),
+        .pin_bit_mask = (1ULL << dev->cdone_gpio),
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = GPIO_PULLUP_DISABLE,
         .pull_down_en = GPIO_PULLDOWN_DISABLE,
@@ -297,8 +2474,71 @@ esp_err_t fpga_loader_init(void)
     };
     gpio_config(&cdone_cfg);
 
-    ESP_LOGI(TAG, "FPGA loader initialized (CRESET=%d, CDONE=%d)",
-             CONFIG_FPGA_CRESET_GPIO, CONFIG_FPGA_CDONE_GPIO);
+    // Shared GPIO ISR service for the CDONE edge interrupt (tolerate an
+    // application that installed it already)
+    esp_err_t isr_ret = gpio_install_isr_service(0);
+    if (isr_ret != ESP_OK && isr_ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Failed to install GPIO ISR service: %s", esp_err_to_name(isr_ret));
+        return isr_ret;
+    }
+
+    ESP_LOGI(TAG, "FPGA loader initialized (CS=%d, CRESET=%d, CDONE=%d)",
+             dev->cs_gpio, dev->creset_gpio, dev->cdone_gpio);
+
+    return ESP_OK;
+}
+
+esp_err_t fpga_loader_init(void)
+{
+    return fpga_loader_dev_init(&default_dev);
+}
+
+esp_err_t fpga_loader_verify(const fpga_bin_t *fpga_bin)
+{
+    const uint8_t *data = fpga_bin->start;
+    size_t size = fpga_bin->end - fpga_bin->start;
+
+    if (size < sizeof(fpga_image_header_t) ||
+        memcmp(data, FPGA_IMAGE_MAGIC, 4) != 0) {
+        ESP_LOGW(TAG, "No container header to verify against");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    const fpga_image_header_t *header = (const fpga_image_header_t *)data;
+    if (header->device_id == 0) {
+        return ESP_ERR_NOT_SUPPORTED;  // 0 = any device, nothing to check
+    }
+
+    ice40_reg_dev_t *reg;
+    esp_err_t ret = ice40_reg_init(&reg);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    uint16_t id = 0;
+    ret = ice40_reg_read(reg, FPGA_LOADER_ID_REG_ADDR, &id);
+    ice40_reg_deinit(reg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Identity readback failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    if (id != header->device_id) {
+        ESP_LOGE(TAG, "Device identity mismatch: running %04x, image %04x",
+                 id, header->device_id);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    ESP_LOGI(TAG, "Verified device identity %04x", id);
+    return ESP_OK;
+}
+
+esp_err_t fpga_loader_get_last_stats(fpga_loader_stats_t *out_stats)
+{
+    if (last_stats.total_us == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
+    *out_stats = last_stats;
     return ESP_OK;
 }
@@ -0,0 +1,63 @@
+#include "ice40/ice40_boot.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "ice40_boot";
+
+static ice40_boot_profile_t profile;
+static bool stage_open;
+
+void ice40_boot_stage_begin(const char *name)
+{
+    if (stage_open) {
+        ice40_boot_stage_end();
+    }
+    if (profile.count >= ICE40_BOOT_MAX_STAGES) {
+        return;
+    }
+
+    profile.stages[profile.count].name = name;
+    profile.stages[profile.count].start_us = esp_timer_get_time();
+    stage_open = true;
+}
+
+void ice40_boot_stage_end(void)
+{
+    if (!stage_open) {
+        return;
+    }
+
+    ice40_boot_stage_t *stage = &profile.stages[profile.count];
+    stage->duration_us = esp_timer_get_time() - stage->start_us;
+    profile.count++;
+    stage_open = false;
+
+    profile.total_us = stage->start_us + stage->duration_us - profile.stages[0].start_us;
+}
+
+void ice40_boot_profile_get(ice40_boot_profile_t *out_profile)
+{
+    *out_profile = profile;
+}
+
+void ice40_boot_report(void)
+{
+    char line[ICE40_BOOT_MAX_STAGES * 32 + 32];
+    size_t pos = (size_t)snprintf(line, sizeof(line), "BOOT");
+
+    for (size_t i = 0; i < profile.count && pos < sizeof(line); i++) {
+        pos += (size_t)snprintf(line + pos, sizeof(line) - pos, ",%s=%lld",
+                                profile.stages[i].name, profile.stages[i].duration_us);
+    }
+    if (pos < sizeof(line)) {
+        snprintf(line + pos, sizeof(line) - pos, ",total=%lld", profile.total_us);
+    }
+
+    printf("%s\n", line);
+    ESP_LOGI(TAG, "Boot complete in %lld us across %d stages",
+             profile.total_us, profile.count);
+}
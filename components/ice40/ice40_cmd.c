@@ -0,0 +1,327 @@
+#include "ice40/ice40_cmd.h"
+#include "ice40/master_spi.h"
+
+#include <driver/spi_master.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// Wire framing shared with ice40_reg.c (see fpga/rtl/spi_slave_reg.v)
+#define CMD_HEADER_SIZE 4
+
+// How often the engine task wakes to check for shutdown while idle
+#define CMD_POLL_MS 100
+
+#define CMD_QUEUE_DEPTH_DEFAULT 16
+
+static const char *TAG = "ice40_cmd";
+
+typedef struct {
+    spi_transaction_ext_t trans;  // Must be first: completed transactions
+                                  // cast back to their slot
+    uint8_t *frame;               // DMA staging: header + payload for writes,
+                                  // received words for reads
+    ice40_cmd_op_t ops[ICE40_CMD_BATCH];
+    size_t op_count;
+    size_t word_count;
+    bool write;
+} cmd_slot_t;
+
+struct ice40_cmd {
+    spi_device_handle_t device;
+    QueueHandle_t ops;
+    cmd_slot_t slots[ICE40_CMD_PIPELINE];
+    size_t next_slot;       // Round-robin slot cursor, engine task only
+    size_t in_flight;
+    ice40_cmd_op_t carry;   // Op popped for merging that didn't fit
+    bool have_carry;
+    ice40_cmd_stats_t stats;
+    TaskHandle_t task;
+    SemaphoreHandle_t exited;
+    volatile bool shutdown;
+};
+
+static void cmd_complete_op(ice40_cmd_t *cmd, ice40_cmd_op_t *op, esp_err_t result)
+{
+    if (op->result != NULL) {
+        *op->result = result;
+    }
+    if (op->done != NULL) {
+        op->done(result, op->done_ctx);
+    }
+    if (op->notify_task != NULL) {
+        xTaskNotifyGive(op->notify_task);
+    }
+    cmd->stats.ops++;
+}
+
+static void cmd_complete_slot(ice40_cmd_t *cmd, cmd_slot_t *slot, esp_err_t result)
+{
+    if (!slot->write && result == ESP_OK) {
+        // Words arrive big-endian; scatter them back to each op's buffer
+        const uint8_t *bytes = slot->frame;
+        size_t word = 0;
+        for (size_t i = 0; i < slot->op_count; i++) {
+            ice40_cmd_op_t *op = &slot->ops[i];
+            for (size_t w = 0; w < op->count; w++, word++) {
+                op->words[w] = (bytes[word * 2] << 8) | bytes[word * 2 + 1];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < slot->op_count; i++) {
+        cmd_complete_op(cmd, &slot->ops[i], result);
+    }
+    slot->op_count = 0;
+}
+
+// Retire the oldest in-flight transaction and run its completions
+static void cmd_reap(ice40_cmd_t *cmd)
+{
+    spi_transaction_t *done;
+    esp_err_t ret = spi_device_get_trans_result(cmd->device, &done, portMAX_DELAY);
+    cmd->in_flight--;
+    cmd_complete_slot(cmd, (cmd_slot_t *)done, ret);
+}
+
+static bool cmd_slot_accepts(const cmd_slot_t *slot, const ice40_cmd_op_t *op)
+{
+    if (slot->op_count >= ICE40_CMD_BATCH || op->write != slot->write) {
+        return false;
+    }
+    if (slot->word_count + op->count > ICE40_REG_MAX_BURST) {
+        return false;
+    }
+    // Auto-increment: the op must continue exactly where the burst ends
+    return op->address == (uint16_t)(slot->ops[0].address + slot->word_count);
+}
+
+static void cmd_slot_add(cmd_slot_t *slot, const ice40_cmd_op_t *op)
+{
+    if (slot->op_count == 0) {
+        slot->write = op->write;
+        slot->word_count = 0;
+        if (op->write) {
+            slot->frame[0] = ICE40_REG_CMD_WRITE_MEM;
+            slot->frame[1] = op->address >> 8;
+            slot->frame[2] = op->address & 0xFF;
+            slot->frame[3] = 0x00;  // Dummy byte for the RTL's clock domain crossing
+        }
+    }
+
+    if (op->write) {
+        uint8_t *payload = slot->frame + CMD_HEADER_SIZE + slot->word_count * 2;
+        for (size_t i = 0; i < op->count; i++) {
+            payload[i * 2] = op->words[i] >> 8;
+            payload[i * 2 + 1] = op->words[i] & 0xFF;
+        }
+    }
+
+    slot->ops[slot->op_count++] = *op;
+    slot->word_count += op->count;
+}
+
+static void cmd_issue_slot(ice40_cmd_t *cmd, cmd_slot_t *slot)
+{
+    spi_transaction_ext_t *trans = &slot->trans;
+    memset(trans, 0, sizeof(*trans));
+
+    if (slot->write) {
+        // The frame carries command/address/dummy itself; suppress the
+        // device's phases so the burst goes out as one data phase
+        trans->base.flags = SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_ADDR |
+                            SPI_TRANS_VARIABLE_DUMMY;
+        trans->base.length = (CMD_HEADER_SIZE + slot->word_count * 2) * 8;
+        trans->base.tx_buffer = slot->frame;
+    } else {
+        trans->base.cmd = ICE40_REG_CMD_READ_MEM;
+        trans->base.addr = slot->ops[0].address;
+        trans->base.rxlength = slot->word_count * 16;
+        trans->base.rx_buffer = slot->frame;
+    }
+
+    esp_err_t ret = spi_device_queue_trans(cmd->device, &trans->base, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Queue failed: %s", esp_err_to_name(ret));
+        cmd_complete_slot(cmd, slot, ret);
+        return;
+    }
+
+    // Advance the cursor only on success so a failed slot is retried in
+    // place; issue order then matches completion order and the cursor's
+    // slot is always free whenever the pipeline has room
+    cmd->next_slot = (cmd->next_slot + 1) % ICE40_CMD_PIPELINE;
+    cmd->in_flight++;
+    cmd->stats.transactions++;
+}
+
+static void cmd_task(void *arg)
+{
+    ice40_cmd_t *cmd = (ice40_cmd_t *)arg;
+
+    while (!cmd->shutdown) {
+        ice40_cmd_op_t op;
+        if (cmd->have_carry) {
+            op = cmd->carry;
+            cmd->have_carry = false;
+        } else {
+            // With transactions in flight poll the queue so completions
+            // retire promptly even when no new ops arrive
+            TickType_t wait = cmd->in_flight > 0 ? 0 : pdMS_TO_TICKS(CMD_POLL_MS);
+            if (xQueueReceive(cmd->ops, &op, wait) != pdTRUE) {
+                if (cmd->in_flight > 0) {
+                    cmd_reap(cmd);
+                }
+                continue;
+            }
+        }
+
+        if (cmd->in_flight == ICE40_CMD_PIPELINE) {
+            cmd_reap(cmd);
+        }
+        cmd_slot_t *slot = &cmd->slots[cmd->next_slot];
+        cmd_slot_add(slot, &op);
+
+        // Greedily fold queued ops that extend this burst contiguously
+        while (xQueueReceive(cmd->ops, &op, 0) == pdTRUE) {
+            if (!cmd_slot_accepts(slot, &op)) {
+                cmd->carry = op;
+                cmd->have_carry = true;
+                break;
+            }
+            cmd_slot_add(slot, &op);
+            cmd->stats.merged++;
+        }
+
+        cmd_issue_slot(cmd, slot);
+    }
+
+    // Retire what is already on the wire, then fail ops never issued
+    while (cmd->in_flight > 0) {
+        cmd_reap(cmd);
+    }
+
+    ice40_cmd_op_t op;
+    while (cmd->have_carry || xQueueReceive(cmd->ops, &op, 0) == pdTRUE) {
+        if (cmd->have_carry) {
+            op = cmd->carry;
+            cmd->have_carry = false;
+        }
+        cmd_complete_op(cmd, &op, ESP_ERR_INVALID_STATE);
+    }
+
+    xSemaphoreGive(cmd->exited);
+    vTaskDelete(NULL);
+}
+
+esp_err_t ice40_cmd_init(ice40_cmd_t **out_cmd, const ice40_cmd_config_t *config)
+{
+    size_t depth = CMD_QUEUE_DEPTH_DEFAULT;
+    if (config != NULL && config->queue_depth > 0) {
+        depth = config->queue_depth;
+    }
+
+    ice40_cmd_t *cmd = calloc(1, sizeof(ice40_cmd_t));
+    if (cmd == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    for (size_t i = 0; i < ICE40_CMD_PIPELINE; i++) {
+        cmd->slots[i].frame = heap_caps_malloc(CMD_HEADER_SIZE + ICE40_REG_MAX_BURST * 2,
+                                               MALLOC_CAP_DMA);
+        if (cmd->slots[i].frame == NULL) {
+            goto fail;
+        }
+    }
+
+    cmd->ops = xQueueCreate(depth, sizeof(ice40_cmd_op_t));
+    cmd->exited = xSemaphoreCreateBinary();
+    if (cmd->ops == NULL || cmd->exited == NULL) {
+        goto fail;
+    }
+
+    // Same device setup as ice40_reg, but with a transaction queue deep
+    // enough to keep the bus busy across commands
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = CONFIG_FPGA_SPI_FREQ_COMMS * 1000000,
+        .mode = 3,  // spi_slave_reg uses SPI Mode 3
+        .spics_io_num = CONFIG_FPGA_CS_GPIO,
+        .queue_size = ICE40_CMD_PIPELINE,
+        .command_bits = 8,
+        .address_bits = 16,
+        .dummy_bits = 8,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+    };
+
+    ret = spi_bus_add_device(FSPI_HOST, &devcfg, &cmd->device);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add SPI device: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+
+    if (xTaskCreate(cmd_task, "ice40_cmd", 3072, cmd, 10, &cmd->task) != pdPASS) {
+        spi_bus_remove_device(cmd->device);
+        ret = ESP_ERR_NO_MEM;
+        goto fail;
+    }
+
+    *out_cmd = cmd;
+    return ESP_OK;
+
+fail:
+    if (cmd->exited != NULL) {
+        vSemaphoreDelete(cmd->exited);
+    }
+    if (cmd->ops != NULL) {
+        vQueueDelete(cmd->ops);
+    }
+    for (size_t i = 0; i < ICE40_CMD_PIPELINE; i++) {
+        heap_caps_free(cmd->slots[i].frame);
+    }
+    free(cmd);
+    return ret;
+}
+
+esp_err_t ice40_cmd_deinit(ice40_cmd_t *cmd)
+{
+    if (cmd == NULL) {
+        return ESP_OK;
+    }
+
+    cmd->shutdown = true;
+    xSemaphoreTake(cmd->exited, portMAX_DELAY);
+
+    esp_err_t ret = spi_bus_remove_device(cmd->device);
+    vSemaphoreDelete(cmd->exited);
+    vQueueDelete(cmd->ops);
+    for (size_t i = 0; i < ICE40_CMD_PIPELINE; i++) {
+        heap_caps_free(cmd->slots[i].frame);
+    }
+    free(cmd);
+
+    return ret;
+}
+
+esp_err_t ice40_cmd_submit(ice40_cmd_t *cmd, const ice40_cmd_op_t *op, TickType_t timeout)
+{
+    if (op->count == 0 || op->count > ICE40_REG_MAX_BURST || op->words == NULL) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (xQueueSend(cmd->ops, op, timeout) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+void ice40_cmd_get_stats(ice40_cmd_t *cmd, ice40_cmd_stats_t *out_stats)
+{
+    *out_stats = cmd->stats;
+}
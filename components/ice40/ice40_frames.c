@@ -0,0 +1,268 @@
+#include "ice40/ice40_frames.h"
+#include "ice40/master_spi.h"
+
+#include <driver/spi_master.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// How often the submitter task wakes to check for shutdown while idle
+#define FRAMES_POLL_MS 100
+
+static const char *TAG = "ice40_frames";
+
+typedef struct {
+    spi_transaction_t trans;  // Must stay first: completed transactions
+                              // are cast back to their slot
+    uint8_t *buffer;
+} frame_slot_t;
+
+struct ice40_frames {
+    spi_device_handle_t device;
+    size_t frame_size;
+    size_t depth;
+    frame_slot_t *slots;
+    uint8_t *buffers;           // depth frame buffers (DMA)
+    QueueHandle_t free_frames;  // frame_slot_t *: buffers producers may fill
+    QueueHandle_t pending;      // frame_slot_t *: filled, oldest first
+    esp_timer_handle_t timer;
+    TaskHandle_t task;
+    SemaphoreHandle_t exited;
+    uint32_t submitted;
+    uint32_t sent;
+    uint32_t dropped;
+    int in_flight;  // Transactions queued but not yet reaped (task-owned)
+    volatile bool shutdown;
+};
+
+static void frames_tick(void *arg)
+{
+    ice40_frames_t *f = (ice40_frames_t *)arg;
+    xTaskNotifyGive(f->task);
+}
+
+// Recycle every transaction the driver has finished with; each slot has
+// its own descriptor, so completions can be reaped lazily
+static void frames_reap(ice40_frames_t *f, TickType_t timeout)
+{
+    spi_transaction_t *done;
+    while (spi_device_get_trans_result(f->device, &done, timeout) == ESP_OK) {
+        frame_slot_t *slot = (frame_slot_t *)done;
+        f->sent++;
+        f->in_flight--;
+        xQueueSend(f->free_frames, &slot, portMAX_DELAY);
+        timeout = 0;
+    }
+}
+
+static void frames_task(void *arg)
+{
+    ice40_frames_t *f = (ice40_frames_t *)arg;
+
+    while (!f->shutdown) {
+        // One notification per timer tick; ticks with nothing pending
+        // just lower the effective frame rate
+        if (ulTaskNotifyTake(pdFALSE, pdMS_TO_TICKS(FRAMES_POLL_MS)) == 0) {
+            frames_reap(f, 0);
+            continue;
+        }
+
+        frames_reap(f, 0);
+
+        frame_slot_t *slot;
+        if (xQueueReceive(f->pending, &slot, 0) != pdTRUE) {
+            continue;
+        }
+
+        memset(&slot->trans, 0, sizeof(spi_transaction_t));
+        slot->trans.length = f->frame_size * 8;
+        slot->trans.tx_buffer = slot->buffer;
+
+        esp_err_t ret = spi_device_queue_trans(f->device, &slot->trans, portMAX_DELAY);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Queue failed: %s", esp_err_to_name(ret));
+            xQueueSend(f->free_frames, &slot, portMAX_DELAY);
+        } else {
+            f->in_flight++;
+        }
+    }
+
+    // Wait out anything still on the wire before the handle is freed
+    while (f->in_flight > 0) {
+        frames_reap(f, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(f->exited);
+    vTaskDelete(NULL);
+}
+
+esp_err_t ice40_frames_init(ice40_frames_t **out_frames,
+                            const ice40_frames_config_t *config)
+{
+    if (config == NULL || config->frame_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t rate_hz = config->rate_hz ? config->rate_hz : ICE40_FRAMES_DEFAULT_RATE_HZ;
+    size_t depth = config->depth ? config->depth : ICE40_FRAMES_DEFAULT_DEPTH;
+
+    ice40_frames_t *f = calloc(1, sizeof(ice40_frames_t));
+    if (f == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    f->frame_size = config->frame_size;
+    f->depth = depth;
+    f->slots = calloc(depth, sizeof(frame_slot_t));
+    f->buffers = heap_caps_malloc(depth * config->frame_size, MALLOC_CAP_DMA);
+    f->free_frames = xQueueCreate(depth, sizeof(frame_slot_t *));
+    f->pending = xQueueCreate(depth, sizeof(frame_slot_t *));
+    f->exited = xSemaphoreCreateBinary();
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (f->slots == NULL || f->buffers == NULL || f->free_frames == NULL ||
+        f->pending == NULL || f->exited == NULL) {
+        goto fail;
+    }
+
+    for (size_t i = 0; i < depth; i++) {
+        frame_slot_t *slot = &f->slots[i];
+        slot->buffer = f->buffers + (i * config->frame_size);
+        xQueueSend(f->free_frames, &slot, 0);
+    }
+
+    // Hardware CS frames each transaction, which is what makes the FPGA
+    // latch the new frame
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = CONFIG_FPGA_SPI_FREQ_COMMS * 1000000,
+        .mode = 0,
+        .spics_io_num = CONFIG_FPGA_CS_GPIO,
+        .queue_size = depth,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+    };
+
+    ret = spi_bus_add_device(FSPI_HOST, &devcfg, &f->device);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add SPI device: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+
+    if (xTaskCreate(frames_task, "ice40_frames", 3072, f, 10, &f->task) != pdPASS) {
+        ret = ESP_ERR_NO_MEM;
+        goto fail_device;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = frames_tick,
+        .arg = f,
+        .name = "ice40_frames",
+    };
+    ret = esp_timer_create(&timer_args, &f->timer);
+    if (ret != ESP_OK) {
+        goto fail_task;
+    }
+
+    ret = esp_timer_start_periodic(f->timer, 1000000 / rate_hz);
+    if (ret != ESP_OK) {
+        esp_timer_delete(f->timer);
+        goto fail_task;
+    }
+
+    ESP_LOGI(TAG, "Streaming %d-byte frames at %uHz, pool depth %d",
+             config->frame_size, rate_hz, depth);
+
+    *out_frames = f;
+    return ESP_OK;
+
+fail_task:
+    f->shutdown = true;
+    xTaskNotifyGive(f->task);
+    xSemaphoreTake(f->exited, portMAX_DELAY);
+fail_device:
+    spi_bus_remove_device(f->device);
+fail:
+    if (f->exited != NULL) {
+        vSemaphoreDelete(f->exited);
+    }
+    if (f->pending != NULL) {
+        vQueueDelete(f->pending);
+    }
+    if (f->free_frames != NULL) {
+        vQueueDelete(f->free_frames);
+    }
+    heap_caps_free(f->buffers);
+    free(f->slots);
+    free(f);
+    return ret;
+}
+
+esp_err_t ice40_frames_deinit(ice40_frames_t *frames)
+{
+    if (frames == NULL) {
+        return ESP_OK;
+    }
+
+    esp_timer_stop(frames->timer);
+    esp_timer_delete(frames->timer);
+
+    frames->shutdown = true;
+    xTaskNotifyGive(frames->task);
+    xSemaphoreTake(frames->exited, portMAX_DELAY);
+
+    spi_bus_remove_device(frames->device);
+    vSemaphoreDelete(frames->exited);
+    vQueueDelete(frames->pending);
+    vQueueDelete(frames->free_frames);
+    heap_caps_free(frames->buffers);
+    free(frames->slots);
+    free(frames);
+
+    return ESP_OK;
+}
+
+esp_err_t ice40_frames_acquire(ice40_frames_t *frames, void **out_frame,
+                               TickType_t timeout)
+{
+    frame_slot_t *slot;
+
+    if (xQueueReceive(frames->free_frames, &slot, 0) != pdTRUE) {
+        // Drop-oldest: displace the stalest unsent frame rather than
+        // making the producer wait for the frame rate
+        if (xQueueReceive(frames->pending, &slot, 0) == pdTRUE) {
+            frames->dropped++;
+        } else if (xQueueReceive(frames->free_frames, &slot, timeout) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+
+    *out_frame = slot->buffer;
+    return ESP_OK;
+}
+
+esp_err_t ice40_frames_submit(ice40_frames_t *frames, void *frame)
+{
+    ptrdiff_t offset = (uint8_t *)frame - frames->buffers;
+    if (offset < 0 || (size_t)offset >= frames->frame_size * frames->depth ||
+        offset % frames->frame_size != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    frame_slot_t *slot = &frames->slots[offset / frames->frame_size];
+    frames->submitted++;
+    xQueueSend(frames->pending, &slot, portMAX_DELAY);
+    return ESP_OK;
+}
+
+void ice40_frames_get_stats(ice40_frames_t *frames, ice40_frames_stats_t *stats)
+{
+    stats->submitted = frames->submitted;
+    stats->sent = frames->sent;
+    stats->dropped = frames->dropped;
+}
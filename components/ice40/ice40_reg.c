@@ -0,0 +1,153 @@
+#include "ice40/ice40_reg.h"
+#include "ice40/master_spi.h"
+
+#include <driver/spi_master.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// Wire framing (see fpga/rtl/spi_slave_reg.v): command byte, big-endian
+// 16-bit address, 8 dummy bits, then big-endian 16-bit data words
+#define REG_HEADER_SIZE 4
+
+static const char *TAG = "ice40_reg";
+
+struct ice40_reg_dev {
+    spi_device_handle_t device;
+    uint8_t *tx_frame;  // DMA staging for write bursts: header + payload
+};
+
+esp_err_t ice40_reg_init(ice40_reg_dev_t **out_dev)
+{
+    ice40_reg_dev_t *dev = calloc(1, sizeof(ice40_reg_dev_t));
+    if (dev == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    dev->tx_frame = heap_caps_malloc(REG_HEADER_SIZE + ICE40_REG_MAX_BURST * 2,
+                                     MALLOC_CAP_DMA);
+    if (dev->tx_frame == NULL) {
+        free(dev);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Read transactions use the driver's command/address/dummy phases so
+    // the FPGA's data comes back cleanly after the 8-bit CDC delay; write
+    // transactions override them (variable-length, zeroed) and carry the
+    // whole frame in the data phase instead
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = CONFIG_FPGA_SPI_FREQ_COMMS * 1000000,
+        .mode = 3,  // spi_slave_reg uses SPI Mode 3
+        .spics_io_num = CONFIG_FPGA_CS_GPIO,
+        .queue_size = 1,
+        .command_bits = 8,
+        .address_bits = 16,
+        .dummy_bits = 8,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+    };
+
+    esp_err_t ret = spi_bus_add_device(FSPI_HOST, &devcfg, &dev->device);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add SPI device: %s", esp_err_to_name(ret));
+        heap_caps_free(dev->tx_frame);
+        free(dev);
+        return ret;
+    }
+
+    *out_dev = dev;
+    return ESP_OK;
+}
+
+esp_err_t ice40_reg_deinit(ice40_reg_dev_t *dev)
+{
+    if (dev == NULL) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = spi_bus_remove_device(dev->device);
+    heap_caps_free(dev->tx_frame);
+    free(dev);
+    return ret;
+}
+
+esp_err_t ice40_reg_read_burst(ice40_reg_dev_t *dev, uint16_t address,
+                               uint16_t *words, size_t count)
+{
+    if (count == 0 || count > ICE40_REG_MAX_BURST) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    spi_transaction_t trans = {
+        .cmd = ICE40_REG_CMD_READ_MEM,
+        .addr = address,
+        .rxlength = count * 16,
+        .rx_buffer = words,
+    };
+
+    esp_err_t ret = spi_device_transmit(dev->device, &trans);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // Words arrive big-endian; swap in place to host byte order
+    uint8_t *bytes = (uint8_t *)words;
+    for (size_t i = 0; i < count; i++) {
+        words[i] = (bytes[i * 2] << 8) | bytes[i * 2 + 1];
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t ice40_reg_write_burst(ice40_reg_dev_t *dev, uint16_t address,
+                                const uint16_t *words, size_t count)
+{
+    if (count == 0 || count > ICE40_REG_MAX_BURST) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint8_t *frame = dev->tx_frame;
+    frame[0] = ICE40_REG_CMD_WRITE_MEM;
+    frame[1] = address >> 8;
+    frame[2] = address & 0xFF;
+    frame[3] = 0x00;  // Dummy byte for the RTL's clock domain crossing
+    for (size_t i = 0; i < count; i++) {
+        frame[REG_HEADER_SIZE + i * 2] = words[i] >> 8;
+        frame[REG_HEADER_SIZE + i * 2 + 1] = words[i] & 0xFF;
+    }
+
+    // Suppress the device's command/address/dummy phases: the frame above
+    // already carries them, so the whole burst goes out as one data phase
+    spi_transaction_ext_t trans = {
+        .base = {
+            .flags = SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY,
+            .length = (REG_HEADER_SIZE + count * 2) * 8,
+            .tx_buffer = frame,
+        },
+        .command_bits = 0,
+        .address_bits = 0,
+        .dummy_bits = 0,
+    };
+
+    return spi_device_transmit(dev->device, &trans.base);
+}
+
+esp_err_t ice40_reg_read(ice40_reg_dev_t *dev, uint16_t address, uint16_t *value)
+{
+    // Single-word read through the driver's frame buffer so callers don't
+    // need a DMA-capable pointer for one register
+    uint16_t *word = (uint16_t *)dev->tx_frame;
+    esp_err_t ret = ice40_reg_read_burst(dev, address, word, 1);
+    if (ret == ESP_OK) {
+        *value = *word;
+    }
+    return ret;
+}
+
+esp_err_t ice40_reg_write(ice40_reg_dev_t *dev, uint16_t address, uint16_t value)
+{
+    return ice40_reg_write_burst(dev, address, &value, 1);
+}
@@ -0,0 +1,294 @@
+#include "ice40/ice40_telemetry.h"
+#include "ice40/master_spi.h"
+
+#include <driver/spi_master.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// Transactions kept in flight so the next read clocks while the
+// previous sample is being published
+#define TELEMETRY_PIPELINE 2
+
+// How often the reader task wakes to check for shutdown while idle
+#define TELEMETRY_POLL_MS 100
+
+static const char *TAG = "ice40_telemetry";
+
+struct ice40_telemetry {
+    spi_device_handle_t device;
+    size_t sample_size;
+    size_t depth;        // Ring depth in samples, power of two
+    uint8_t *slots;      // depth * sample_size sample ring
+    uint8_t *dma_bufs;   // TELEMETRY_PIPELINE receive bounce buffers
+    uint32_t seq;        // Samples published; slot for sample n is n & (depth - 1)
+    uint32_t read_seq;   // Consumer cursor (consumer-owned)
+    uint32_t dropped;    // Samples the consumer was too slow to collect
+    esp_timer_handle_t timer;
+    TaskHandle_t task;
+    SemaphoreHandle_t doorbell;  // Wakes a blocked ice40_telemetry_read()
+    SemaphoreHandle_t exited;
+    volatile bool shutdown;
+};
+
+static void telemetry_tick(void *arg)
+{
+    ice40_telemetry_t *t = (ice40_telemetry_t *)arg;
+    xTaskNotifyGive(t->task);
+}
+
+// Copy a completed sample into the ring and publish it. The release
+// store orders the slot contents before the new sequence number, so a
+// consumer that observes the count also observes the data.
+static void telemetry_publish(ice40_telemetry_t *t, const uint8_t *sample)
+{
+    uint32_t seq = t->seq;
+    memcpy(&t->slots[(seq & (t->depth - 1)) * t->sample_size], sample, t->sample_size);
+    __atomic_store_n(&t->seq, seq + 1, __ATOMIC_RELEASE);
+    xSemaphoreGive(t->doorbell);
+}
+
+static void telemetry_task(void *arg)
+{
+    ice40_telemetry_t *t = (ice40_telemetry_t *)arg;
+
+    spi_transaction_t trans[TELEMETRY_PIPELINE];
+    memset(trans, 0, sizeof(trans));
+    for (int i = 0; i < TELEMETRY_PIPELINE; i++) {
+        trans[i].rxlength = t->sample_size * 8;
+        trans[i].rx_buffer = t->dma_bufs + (i * t->sample_size);
+    }
+
+    int next = 0;       // Pipeline slot to queue on the next tick
+    int in_flight = 0;  // Queued transactions not yet retired
+
+    while (!t->shutdown) {
+        // One notification per timer tick; a backlog of missed ticks
+        // drains one sample at a time rather than being discarded
+        if (ulTaskNotifyTake(pdFALSE, pdMS_TO_TICKS(TELEMETRY_POLL_MS)) == 0) {
+            continue;
+        }
+
+        esp_err_t ret = spi_device_queue_trans(t->device, &trans[next], portMAX_DELAY);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Queue failed: %s", esp_err_to_name(ret));
+            continue;
+        }
+        next = (next + 1) % TELEMETRY_PIPELINE;
+        in_flight++;
+
+        // Retire the previous read (long since complete by the time the
+        // next tick fires) and publish its sample
+        if (in_flight == TELEMETRY_PIPELINE) {
+            spi_transaction_t *done;
+            ret = spi_device_get_trans_result(t->device, &done, portMAX_DELAY);
+            in_flight--;
+            if (ret == ESP_OK) {
+                telemetry_publish(t, done->rx_buffer);
+            } else {
+                ESP_LOGE(TAG, "Read failed: %s", esp_err_to_name(ret));
+            }
+        }
+    }
+
+    while (in_flight > 0) {
+        spi_transaction_t *done;
+        spi_device_get_trans_result(t->device, &done, portMAX_DELAY);
+        in_flight--;
+    }
+
+    xSemaphoreGive(t->exited);
+    vTaskDelete(NULL);
+}
+
+esp_err_t ice40_telemetry_init(ice40_telemetry_t **out_telemetry,
+                               const ice40_telemetry_config_t *config)
+{
+    if (config == NULL || config->sample_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t rate_hz = config->rate_hz ? config->rate_hz : ICE40_TELEMETRY_DEFAULT_RATE_HZ;
+    size_t depth = config->depth ? config->depth : ICE40_TELEMETRY_DEFAULT_DEPTH;
+    while (depth & (depth - 1)) {
+        depth++;
+    }
+
+    ice40_telemetry_t *t = calloc(1, sizeof(ice40_telemetry_t));
+    if (t == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    t->sample_size = config->sample_size;
+    t->depth = depth;
+    t->slots = malloc(depth * config->sample_size);
+    t->dma_bufs = heap_caps_malloc(TELEMETRY_PIPELINE * config->sample_size, MALLOC_CAP_DMA);
+    t->doorbell = xSemaphoreCreateBinary();
+    t->exited = xSemaphoreCreateBinary();
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (t->slots == NULL || t->dma_bufs == NULL || t->doorbell == NULL || t->exited == NULL) {
+        goto fail;
+    }
+
+    // Same device setup the examples use for spi_slave_bulk designs
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = CONFIG_FPGA_SPI_FREQ_COMMS * 1000000,
+        .mode = 0,
+        .spics_io_num = CONFIG_FPGA_CS_GPIO,
+        .queue_size = TELEMETRY_PIPELINE,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+    };
+
+    ret = spi_bus_add_device(FSPI_HOST, &devcfg, &t->device);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add SPI device: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+
+    if (xTaskCreate(telemetry_task, "ice40_telem", 3072, t, 10, &t->task) != pdPASS) {
+        ret = ESP_ERR_NO_MEM;
+        goto fail_device;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = telemetry_tick,
+        .arg = t,
+        .name = "ice40_telem",
+    };
+    ret = esp_timer_create(&timer_args, &t->timer);
+    if (ret != ESP_OK) {
+        goto fail_task;
+    }
+
+    ret = esp_timer_start_periodic(t->timer, 1000000 / rate_hz);
+    if (ret != ESP_OK) {
+        esp_timer_delete(t->timer);
+        goto fail_task;
+    }
+
+    ESP_LOGI(TAG, "Sampling %d bytes at %uHz, ring depth %d",
+             config->sample_size, rate_hz, depth);
+
+    *out_telemetry = t;
+    return ESP_OK;
+
+fail_task:
+    t->shutdown = true;
+    xTaskNotifyGive(t->task);
+    xSemaphoreTake(t->exited, portMAX_DELAY);
+fail_device:
+    spi_bus_remove_device(t->device);
+fail:
+    if (t->doorbell != NULL) {
+        vSemaphoreDelete(t->doorbell);
+    }
+    if (t->exited != NULL) {
+        vSemaphoreDelete(t->exited);
+    }
+    heap_caps_free(t->dma_bufs);
+    free(t->slots);
+    free(t);
+    return ret;
+}
+
+esp_err_t ice40_telemetry_deinit(ice40_telemetry_t *telemetry)
+{
+    if (telemetry == NULL) {
+        return ESP_OK;
+    }
+
+    esp_timer_stop(telemetry->timer);
+    esp_timer_delete(telemetry->timer);
+
+    telemetry->shutdown = true;
+    xTaskNotifyGive(telemetry->task);
+    xSemaphoreTake(telemetry->exited, portMAX_DELAY);
+
+    spi_bus_remove_device(telemetry->device);
+    vSemaphoreDelete(telemetry->doorbell);
+    vSemaphoreDelete(telemetry->exited);
+    heap_caps_free(telemetry->dma_bufs);
+    free(telemetry->slots);
+    free(telemetry);
+
+    return ESP_OK;
+}
+
+esp_err_t ice40_telemetry_latest(ice40_telemetry_t *telemetry, void *sample)
+{
+    // Seqlock-style copy: re-read the count afterwards to check the
+    // producer didn't lap into the slot mid-copy
+    while (true) {
+        uint32_t seq = __atomic_load_n(&telemetry->seq, __ATOMIC_ACQUIRE);
+        if (seq == 0) {
+            return ESP_ERR_NOT_FOUND;
+        }
+
+        uint32_t index = seq - 1;
+        memcpy(sample,
+               &telemetry->slots[(index & (telemetry->depth - 1)) * telemetry->sample_size],
+               telemetry->sample_size);
+
+        uint32_t after = __atomic_load_n(&telemetry->seq, __ATOMIC_ACQUIRE);
+        if (after - index < telemetry->depth) {
+            return ESP_OK;
+        }
+    }
+}
+
+size_t ice40_telemetry_read(ice40_telemetry_t *telemetry, void *samples,
+                            size_t max_samples, TickType_t timeout)
+{
+    if (max_samples == 0) {
+        return 0;
+    }
+
+    while (true) {
+        uint32_t seq = __atomic_load_n(&telemetry->seq, __ATOMIC_ACQUIRE);
+
+        // Skip over anything the producer has already lapped
+        uint32_t floor = (seq > telemetry->depth) ? seq - telemetry->depth : 0;
+        if (telemetry->read_seq < floor) {
+            telemetry->dropped += floor - telemetry->read_seq;
+            telemetry->read_seq = floor;
+        }
+
+        uint32_t avail = seq - telemetry->read_seq;
+        if (avail == 0) {
+            if (timeout == 0 || xSemaphoreTake(telemetry->doorbell, timeout) != pdTRUE) {
+                return 0;
+            }
+            timeout = 0;  // Wait at most once
+            continue;
+        }
+
+        size_t count = (avail < max_samples) ? avail : max_samples;
+        uint8_t *out = (uint8_t *)samples;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t index = telemetry->read_seq + i;
+            memcpy(out + i * telemetry->sample_size,
+                   &telemetry->slots[(index & (telemetry->depth - 1)) * telemetry->sample_size],
+                   telemetry->sample_size);
+        }
+
+        // The copy is torn if the producer lapped into the oldest copied
+        // slot while we were reading; fall back around and resync
+        uint32_t after = __atomic_load_n(&telemetry->seq, __ATOMIC_ACQUIRE);
+        if (after - telemetry->read_seq < telemetry->depth) {
+            telemetry->read_seq += count;
+            return count;
+        }
+    }
+}
+
+uint32_t ice40_telemetry_dropped(ice40_telemetry_t *telemetry)
+{
+    return telemetry->dropped;
+}
@@ -0,0 +1,132 @@
+#include "ice40/ice40_writer.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// How often the writer task wakes to check for shutdown while idle
+#define WRITER_POLL_MS 100
+
+static const char *TAG = "ice40_writer";
+
+struct ice40_writer {
+    size_t value_size;
+    ice40_writer_flush_cb_t flush_cb;
+    void *user_ctx;
+    uint8_t *pending;   // Latest deposited value
+    uint8_t *staging;   // Snapshot being flushed
+    bool dirty;
+    portMUX_TYPE lock;  // Guards pending/dirty for the copy-in/copy-out
+    TaskHandle_t task;
+    SemaphoreHandle_t exited;
+    volatile bool shutdown;
+};
+
+static void writer_task(void *arg)
+{
+    ice40_writer_t *writer = (ice40_writer_t *)arg;
+
+    while (!writer->shutdown) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WRITER_POLL_MS));
+
+        // Flush until no new value arrived while we were writing; values
+        // deposited mid-flush coalesce into a single extra pass
+        while (true) {
+            portENTER_CRITICAL(&writer->lock);
+            bool dirty = writer->dirty;
+            if (dirty) {
+                memcpy(writer->staging, writer->pending, writer->value_size);
+                writer->dirty = false;
+            }
+            portEXIT_CRITICAL(&writer->lock);
+
+            if (!dirty) {
+                break;
+            }
+
+            esp_err_t ret = writer->flush_cb(writer->staging, writer->value_size,
+                                             writer->user_ctx);
+            if (ret != ESP_OK) {
+                ESP_LOGW(TAG, "Flush failed: %s", esp_err_to_name(ret));
+            }
+        }
+    }
+
+    xSemaphoreGive(writer->exited);
+    vTaskDelete(NULL);
+}
+
+esp_err_t ice40_writer_init(ice40_writer_t **out_writer, size_t value_size,
+                            ice40_writer_flush_cb_t flush_cb, void *user_ctx)
+{
+    if (value_size == 0 || flush_cb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ice40_writer_t *writer = calloc(1, sizeof(ice40_writer_t));
+    if (writer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    writer->value_size = value_size;
+    writer->flush_cb = flush_cb;
+    writer->user_ctx = user_ctx;
+    writer->lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+
+    writer->pending = malloc(value_size);
+    writer->staging = malloc(value_size);
+    writer->exited = xSemaphoreCreateBinary();
+
+    if (writer->pending == NULL || writer->staging == NULL || writer->exited == NULL) {
+        goto fail;
+    }
+
+    if (xTaskCreate(writer_task, "ice40_writer", 3072, writer, 10, &writer->task) != pdPASS) {
+        goto fail;
+    }
+
+    *out_writer = writer;
+    return ESP_OK;
+
+fail:
+    if (writer->exited != NULL) {
+        vSemaphoreDelete(writer->exited);
+    }
+    free(writer->staging);
+    free(writer->pending);
+    free(writer);
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t ice40_writer_deinit(ice40_writer_t *writer)
+{
+    if (writer == NULL) {
+        return ESP_OK;
+    }
+
+    writer->shutdown = true;
+    xTaskNotifyGive(writer->task);
+    xSemaphoreTake(writer->exited, portMAX_DELAY);
+
+    vSemaphoreDelete(writer->exited);
+    free(writer->staging);
+    free(writer->pending);
+    free(writer);
+
+    return ESP_OK;
+}
+
+esp_err_t ice40_writer_submit(ice40_writer_t *writer, const void *value)
+{
+    portENTER_CRITICAL(&writer->lock);
+    memcpy(writer->pending, value, writer->value_size);
+    writer->dirty = true;
+    portEXIT_CRITICAL(&writer->lock);
+
+    xTaskNotifyGive(writer->task);
+    return ESP_OK;
+}
@@ -6,10 +6,23 @@
  *
  * Include this single header to get all ICE40 functionality:
  * - FPGA bitstream loading
+ * - Boot profiler
  * - SPI bus management
+ * - Register protocol driver
+ * - Async command engine
+ * - Telemetry sampler
+ * - Frame streamer
+ * - Coalescing async writer
  * - Binary descriptor types
  */
 
 #include "ice40/fpga_bin.h"
+#include "ice40/fpga_image.h"
 #include "ice40/fpga_loader.h"
+#include "ice40/ice40_boot.h"
+#include "ice40/ice40_cmd.h"
+#include "ice40/ice40_frames.h"
+#include "ice40/ice40_reg.h"
+#include "ice40/ice40_telemetry.h"
+#include "ice40/ice40_writer.h"
 #include "ice40/master_spi.h"
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @defgroup fpga_image Bitstream Container Format
+ * @brief On-storage header for FPGA bitstream images
+ *
+ * Bare bitstreams carry no metadata: the loader can't learn their size
+ * without a stat(), can't verify integrity until CDONE times out after
+ * a full failed load, and can't tell which device they target. Images
+ * produced with `affogato pack` prepend this fixed 16-byte header; all
+ * loader entry points detect and consume it automatically, verifying
+ * the payload length and CRC up front where the image is memory-mapped.
+ *
+ * All multi-byte fields are little-endian.
+ *
+ * @{
+ */
+
+/** @brief Magic bytes identifying a container image */
+#define FPGA_IMAGE_MAGIC "AFBS"
+
+/** @brief Payload is AFLZ-compressed (`affogato compress`) */
+#define FPGA_IMAGE_FLAG_COMPRESSED 0x01
+
+/**
+ * @brief Container header, immediately followed by the payload
+ */
+typedef struct __attribute__((packed)) {
+    char magic[4];       ///< FPGA_IMAGE_MAGIC
+    uint32_t length;     ///< Payload length in bytes (as stored)
+    uint32_t crc32;      ///< CRC32 of the payload (as esp_rom_crc32_le(0, ...))
+    uint16_t device_id;  ///< Target device identity (0 = any)
+    uint8_t flags;       ///< FPGA_IMAGE_FLAG_* bits
+    uint8_t reserved;    ///< Write as zero
+} fpga_image_header_t;
+
+/** @} */
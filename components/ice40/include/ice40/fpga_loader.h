@@ -1,5 +1,9 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <driver/spi_master.h>
 #include <esp_err.h>
 #include "fpga_bin.h"
 
@@ -15,6 +19,10 @@
  * - Loading from embedded ROM (bitstream linked into firmware)
  * - Loading from filesystem (bitstream stored in VFS)
  *
+ * Bitstreams compressed with `affogato compress` (AFLZ container) are
+ * detected automatically and decompressed on the fly with a fixed 4KB
+ * working buffer; the decompressed image is never held in RAM.
+ *
  * Hardware requirements:
  * - SPI connection (MOSI, SCLK, CS directly wired)
  * - CRESET_B GPIO output (active low reset)
@@ -23,6 +31,22 @@
  * @{
  */
 
+/**
+ * @brief One FPGA on the shared SPI bus
+ *
+ * Boards with multiple ICE40s share SCLK/MOSI/MISO but give each device
+ * its own CS, CRESET and CDONE. The single-FPGA API operates on the
+ * device wired per Kconfig (CONFIG_FPGA_CS_GPIO etc.); additional
+ * devices are described with this table entry and passed to
+ * fpga_loader_dev_init() / fpga_loader_ctx_init_for_dev().
+ */
+typedef struct {
+    int cs_gpio;                 ///< Chip select (manual during programming)
+    int creset_gpio;             ///< CRESET_B, active low
+    int cdone_gpio;              ///< CDONE, high when configured
+    spi_device_handle_t device;  ///< Programming SPI device (owned by the ctx)
+} fpga_dev_t;
+
 /**
  * @brief Initialize the FPGA loader hardware
  *
@@ -33,6 +57,17 @@
  */
 esp_err_t fpga_loader_init(void);
 
+/**
+ * @brief fpga_loader_init() for a specific device table entry
+ *
+ * Configures the given device's CRESET/CDONE GPIOs. Call once per FPGA
+ * on multi-device boards (fpga_loader_init() covers the Kconfig one).
+ *
+ * @param dev Device pin set (the SPI handle field is ignored here)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fpga_loader_dev_init(const fpga_dev_t *dev);
+
 /**
  * @brief Load FPGA configuration from embedded ROM
  *
@@ -49,6 +84,20 @@ esp_err_t fpga_loader_init(void);
  */
 esp_err_t fpga_loader_load_from_rom(const fpga_bin_t *fpga_bin);
 
+/**
+ * @brief Load from ROM only if the FPGA isn't already running this image
+ *
+ * On warm restarts (esp_restart(), brownout recovery) the ICE40 usually
+ * still holds its configuration. This checks CDONE plus a CRC32 of the
+ * bitstream recorded in RTC memory by the previous load, and skips the
+ * full programming sequence when both match — taking restart-to-
+ * operational time from ~1s to near zero.
+ *
+ * @param fpga_bin Pointer to fpga_bin_t describing the embedded bitstream
+ * @return ESP_OK on success (including skip), error code otherwise
+ */
+esp_err_t fpga_loader_load_from_rom_if_needed(const fpga_bin_t *fpga_bin);
+
 /**
  * @brief Load FPGA configuration from a file
  *
@@ -60,4 +109,306 @@ esp_err_t fpga_loader_load_from_rom(const fpga_bin_t *fpga_bin);
  */
 esp_err_t fpga_loader_load_from_file(const char *filename);
 
+/**
+ * @brief Partition label the prepared-bitstream cache lives in
+ *
+ * A data partition with this label (any subtype) in the partition table
+ * enables fpga_loader_load_from_file_cached(). It is divided into four
+ * equal slots; size it to hold four prepared (decompressed) bitstreams
+ * plus one erase sector of bookkeeping each.
+ */
+#define FPGA_LOADER_CACHE_PARTITION "fpga_cache"
+
+/**
+ * @brief fpga_loader_load_from_file() with a prepared-bitstream cache
+ *
+ * Filesystem loads pay for VFS reads, container parsing, CRC
+ * verification and AFLZ decompression on every call. For applications
+ * that rotate between a few designs all day, this variant caches the
+ * load-ready representation — decompressed, header-validated, stored
+ * contiguously in the FPGA_LOADER_CACHE_PARTITION partition — keyed by
+ * a content hash of the file. The first load of a given image streams
+ * normally and then writes the prepared copy; every later load of the
+ * same content memory-maps it and streams at full bus speed with zero
+ * preprocessing, like a partition load.
+ *
+ * AFBS containers get their key from the header's payload CRC for
+ * free; bare images pay one extra sequential read to hash the file, so
+ * pack images for the best hit-path behavior. Slots are recycled
+ * oldest-first; a missing cache partition quietly degrades to the
+ * uncached call.
+ *
+ * @param filename Path to the bitstream file (e.g., "/spiffs/top.bin")
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fpga_loader_load_from_file_cached(const char *filename);
+
+/**
+ * @brief Load FPGA configuration from a flash partition
+ *
+ * Memory-maps the partition with esp_partition_mmap() and streams the
+ * bitstream without an intermediate copy wherever the mapped pages are
+ * reachable by the SPI DMA engine (bounce buffers are used otherwise).
+ *
+ * @param label Partition label (as in the partition table)
+ * @param size  Bitstream size in bytes, or 0 to stream the whole partition
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fpga_loader_load_from_partition(const char *label, size_t size);
+
+/**
+ * @brief One fragment of a scattered bitstream
+ *
+ * The bytes are caller-owned and must stay valid for the duration of the
+ * load. Fragments in DMA-reachable memory are transmitted in place;
+ * others are bounced through the loader's chunk buffers.
+ */
+typedef struct {
+    const void *data;  ///< Fragment bytes
+    size_t size;       ///< Fragment length in bytes
+} fpga_loader_frag_t;
+
+/**
+ * @brief Load FPGA configuration from a chain of fragments
+ *
+ * For producers that receive the bitstream in pieces (network buffer
+ * chains, OTA downloads) and would otherwise have to assemble a
+ * contiguous staging copy first. The fragments are streamed in order;
+ * AFLZ-compressed payloads are detected and decompressed as usual.
+ *
+ * @param frags Array of fragments, streamed in array order
+ * @param count Number of fragments
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fpga_loader_load_from_frags(const fpga_loader_frag_t *frags, size_t count);
+
+/**
+ * @brief Persistent loader context
+ *
+ * The one-shot fpga_loader_load_from_*() calls register the programming
+ * SPI device and allocate DMA buffers on every invocation. For workloads
+ * that reload the FPGA repeatedly (development iteration, watchdog
+ * recovery), create a context once and reuse it: a warm reload then only
+ * pays for the actual bitstream transfer.
+ */
+typedef struct fpga_loader_ctx fpga_loader_ctx_t;
+
+/**
+ * @brief Create a persistent loader context
+ *
+ * Pre-allocates the streaming DMA buffers and registers the programming
+ * SPI device. The SPI bus (master_spi_init()) and the loader GPIOs
+ * (fpga_loader_init()) must already be set up.
+ *
+ * @param out_ctx Receives the new context on success
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fpga_loader_ctx_init(fpga_loader_ctx_t **out_ctx);
+
+/**
+ * @brief fpga_loader_ctx_init() bound to a specific device table entry
+ *
+ * All loads through the returned context program the given FPGA. The
+ * context registers its own programming SPI device on the shared bus.
+ *
+ * @param out_ctx Receives the new context on success
+ * @param dev     Device to program (pins copied; SPI handle ignored)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fpga_loader_ctx_init_for_dev(fpga_loader_ctx_t **out_ctx, const fpga_dev_t *dev);
+
+/**
+ * @brief Destroy a loader context, releasing its SPI device and buffers
+ *
+ * @param ctx Context to destroy (NULL is a no-op)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fpga_loader_ctx_deinit(fpga_loader_ctx_t *ctx);
+
+/**
+ * @brief Run source reads on the other core during loads
+ *
+ * When enabled (and the chip has a second core), fpga_loader_ctx_load_*
+ * runs the source-read side — flash reads, AFLZ decompression — as a
+ * task pinned to the core this one isn't on, feeding the SPI-submitting
+ * side through a queue. Useful when WiFi/HTTP interrupt load on the
+ * default core visibly stretches runtime reconfiguration. On single-core
+ * targets (ESP32-S2) this is accepted and loads degrade gracefully to
+ * the single-task pipelined mode.
+ *
+ * @param ctx    Loader context
+ * @param enable true to read from the other core
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for a NULL context
+ */
+esp_err_t fpga_loader_ctx_set_dual_core(fpga_loader_ctx_t *ctx, bool enable);
+
+/** @brief fpga_loader_load_from_rom() against a persistent context */
+esp_err_t fpga_loader_ctx_load_from_rom(fpga_loader_ctx_t *ctx, const fpga_bin_t *fpga_bin);
+
+/** @brief fpga_loader_load_from_file() against a persistent context */
+esp_err_t fpga_loader_ctx_load_from_file(fpga_loader_ctx_t *ctx, const char *filename);
+
+/** @brief fpga_loader_load_from_file_cached() against a persistent context */
+esp_err_t fpga_loader_ctx_load_from_file_cached(fpga_loader_ctx_t *ctx, const char *filename);
+
+/** @brief fpga_loader_load_from_partition() against a persistent context */
+esp_err_t fpga_loader_ctx_load_from_partition(fpga_loader_ctx_t *ctx, const char *label, size_t size);
+
+/** @brief fpga_loader_load_from_frags() against a persistent context */
+esp_err_t fpga_loader_ctx_load_from_frags(fpga_loader_ctx_t *ctx,
+                                          const fpga_loader_frag_t *frags, size_t count);
+
+/**
+ * @brief Configure two FPGAs in barely more time than one
+ *
+ * For boards carrying two ICE40s on the shared bus: both devices go
+ * through the reset handshake together, then bitstream chunks alternate
+ * on the wire with CS steering each chunk to its device (an ICE40
+ * ignores configuration clocks while its SS is high). While one chunk
+ * is clocking out, the other device's next chunk is read — so source
+ * reads and AFLZ decompression for both images are fully overlapped
+ * instead of paid serially.
+ *
+ * @param ctx_a Context for the first FPGA (its SPI device drives the bus)
+ * @param bin_a Bitstream for the first FPGA
+ * @param ctx_b Context for the second FPGA
+ * @param bin_b Bitstream for the second FPGA
+ * @return ESP_OK when both devices report CDONE, error code otherwise
+ */
+esp_err_t fpga_loader_load_from_rom_interleaved(fpga_loader_ctx_t *ctx_a,
+                                                const fpga_bin_t *bin_a,
+                                                fpga_loader_ctx_t *ctx_b,
+                                                const fpga_bin_t *bin_b);
+
+/**
+ * @brief In-flight streaming load (see fpga_loader_stream_begin())
+ */
+typedef struct fpga_loader_stream fpga_loader_stream_t;
+
+/**
+ * @brief Begin loading the FPGA from a byte stream
+ *
+ * For remote reconfiguration: instead of downloading a bitstream to
+ * flash and then loading it, a producer (e.g. an esp_http_client event
+ * handler) pushes bytes as they arrive while a background task clocks
+ * them into the FPGA concurrently, so total time is max(download, load)
+ * rather than the sum — and the bitstream never touches flash.
+ *
+ * Usage:
+ * @code
+ * fpga_loader_stream_t *stream;
+ * fpga_loader_stream_begin(content_length, &stream);
+ * // per chunk received:
+ * fpga_loader_stream_write(stream, chunk, chunk_len);
+ * // after the last chunk (or on connection error):
+ * esp_err_t result = fpga_loader_stream_finish(stream);
+ * @endcode
+ *
+ * @param size       Payload size in bytes as transferred (the compressed
+ *                   size for AFLZ payloads); must be known up front
+ * @param out_stream Receives the stream handle
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fpga_loader_stream_begin(size_t size, fpga_loader_stream_t **out_stream);
+
+/**
+ * @brief Push the next run of payload bytes into a streaming load
+ *
+ * Blocks while the ring buffer is full (the FPGA clocking is behind the
+ * network). Returns the load error early if the consumer has already
+ * failed, so the producer can abandon the transfer.
+ *
+ * @param stream Stream handle from fpga_loader_stream_begin()
+ * @param data   Payload bytes
+ * @param size   Number of bytes
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fpga_loader_stream_write(fpga_loader_stream_t *stream,
+                                   const void *data, size_t size);
+
+/**
+ * @brief Complete a streaming load and release the stream
+ *
+ * Call after the last write — or early, to abort on a dropped
+ * connection (the load then fails with a read error). Blocks until the
+ * programming sequence finishes and returns its result. The handle is
+ * freed either way.
+ *
+ * @param stream Stream handle from fpga_loader_stream_begin()
+ * @return Result of the load
+ */
+esp_err_t fpga_loader_stream_finish(fpga_loader_stream_t *stream);
+
+/**
+ * @brief Find this board's maximum reliable programming clock
+ *
+ * CONFIG_FPGA_SPI_FREQ_PROGRAMMING is necessarily conservative; a given
+ * board's wiring usually sustains more. This bisects between the
+ * configured frequency and the ICE40 limit (25 MHz), doing a full load
+ * of the supplied bitstream at each candidate and treating CDONE as the
+ * pass/fail signal. The winning frequency is stored in NVS (namespace
+ * "ice40") and picked up automatically by all subsequent loads, so this
+ * only needs to run once per board (e.g. from a factory-test build).
+ *
+ * NVS must be initialized (nvs_flash_init()) for the result to persist;
+ * without it the calibrated value still applies until reboot.
+ *
+ * @param fpga_bin     Bitstream to calibrate with (loaded several times)
+ * @param out_freq_mhz Receives the calibrated frequency; may be NULL
+ * @return ESP_OK on success, ESP_FAIL if even the configured frequency
+ *         fails to configure the FPGA
+ */
+esp_err_t fpga_loader_calibrate(const fpga_bin_t *fpga_bin, int *out_freq_mhz);
+
+/**
+ * @brief spi_slave_reg address of the standard identity register
+ *
+ * The RTL templates expose the design's device ID here; see
+ * fpga_loader_verify().
+ */
+#define FPGA_LOADER_ID_REG_ADDR 0
+
+/**
+ * @brief Confirm the running design matches a container image
+ *
+ * CDONE only proves that *a* configuration completed — a stale
+ * bitstream after a partial flash write passes it happily. Designs
+ * built from the templates answer with their device ID at
+ * spi_slave_reg address 0; this reads it back (one short transaction)
+ * and compares it against the image's AFBS header.
+ *
+ * @param fpga_bin Container image the FPGA is expected to be running
+ * @return ESP_OK when the identities match, ESP_ERR_INVALID_VERSION on
+ *         a mismatch, ESP_ERR_NOT_SUPPORTED for bare images or a
+ *         device_id of 0 (any device)
+ */
+esp_err_t fpga_loader_verify(const fpga_bin_t *fpga_bin);
+
+/**
+ * @brief Timing breakdown of the most recent load
+ *
+ * Populated on every load (esp_timer microseconds) so slow boots can be
+ * attributed to flash reads, SPI clocking, or the CDONE wait, and so
+ * buffer-size/frequency tuning has numbers to work from.
+ */
+typedef struct {
+    int64_t total_us;        ///< Full programming sequence (steps 1-10)
+    int64_t reset_us;        ///< Reset and handshake (steps 1-6)
+    int64_t stream_us;       ///< Bitstream streaming loop (step 7)
+    int64_t source_read_us;  ///< Accumulated source read()/map() time
+    int64_t spi_wait_us;     ///< Accumulated waiting on SPI completions
+    int64_t cdone_wait_us;   ///< CDONE wait (step 8)
+    size_t bytes;            ///< Bitstream bytes streamed
+    size_t chunks;           ///< Chunks transmitted
+    float mbytes_per_sec;    ///< Derived: bytes / stream_us
+} fpga_loader_stats_t;
+
+/**
+ * @brief Retrieve the timing breakdown of the last completed load
+ *
+ * @param out_stats Receives a copy of the stats
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE if nothing has loaded yet
+ */
+esp_err_t fpga_loader_get_last_stats(fpga_loader_stats_t *out_stats);
+
 /** @} */
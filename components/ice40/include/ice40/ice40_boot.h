@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @defgroup ice40_boot Boot Profiler
+ * @brief Checkpoint timing for the canonical boot sequence
+ *
+ * Every firmware variant boots through the same stages — SPI bus init,
+ * loader init, bitstream load, then application bring-up — but finding
+ * out where a slow SKU spends its 400ms has meant hand-instrumenting
+ * each one. These checkpoints make it standard: bracket each stage
+ * with begin/end, print the one-line summary at the end of app_main,
+ * and fetch the struct if the numbers should ship over telemetry.
+ *
+ * Costs one esp_timer read per call; intended for the single-threaded
+ * boot path, not for concurrent use.
+ *
+ * @{
+ */
+
+/** @brief Stages recorded before further checkpoints are dropped */
+#define ICE40_BOOT_MAX_STAGES 12
+
+/**
+ * @brief One timed boot stage
+ */
+typedef struct {
+    const char *name;     ///< Stage name (not copied; use string literals)
+    int64_t start_us;     ///< Stage start, microseconds since boot
+    int64_t duration_us;  ///< Stage duration in microseconds
+} ice40_boot_stage_t;
+
+/**
+ * @brief Recorded boot profile
+ */
+typedef struct {
+    ice40_boot_stage_t stages[ICE40_BOOT_MAX_STAGES];
+    size_t count;      ///< Completed stages
+    int64_t total_us;  ///< First stage start to last stage end
+} ice40_boot_profile_t;
+
+/**
+ * @brief Open a named stage, closing any stage still open
+ *
+ * @param name Stage name; must outlive the profile (string literal)
+ */
+void ice40_boot_stage_begin(const char *name);
+
+/**
+ * @brief Close the currently open stage
+ */
+void ice40_boot_stage_end(void);
+
+/**
+ * @brief Copy out the profile recorded so far
+ *
+ * @param out_profile Receives the completed stages and total
+ */
+void ice40_boot_profile_get(ice40_boot_profile_t *out_profile);
+
+/**
+ * @brief Print the machine-parsable one-line summary
+ *
+ * Format: `BOOT,<name>=<us>,...,total=<us>` — same shape as the
+ * benchmark app's BENCH lines, so the rack tooling can scrape both.
+ */
+void ice40_boot_report(void);
+
+/** @} */
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "ice40/ice40_reg.h"
+
+/**
+ * @defgroup ice40_cmd Async Command Engine
+ * @brief Queued, pipelined register traffic over the spi_slave_reg protocol
+ *
+ * The blocking register driver serializes every access: the caller
+ * holds the bus mutex for a full round trip, and the bus idles between
+ * transactions while the caller runs. A control loop built on it tops
+ * out well below what the link can carry.
+ *
+ * This engine decouples the two sides. Callers enqueue operations and
+ * get completions via callback or task notification; a dedicated task
+ * keeps ICE40_CMD_PIPELINE transactions on the SPI queue so the next
+ * transfer starts while the previous one is being retired, and merges
+ * queued operations at contiguous addresses into a single
+ * auto-increment burst (one command/address header, one CS assertion).
+ *
+ * The engine owns its own SPI device on the shared bus; do not use it
+ * concurrently with a blocking ice40_reg device on the same CS.
+ *
+ * @{
+ */
+
+/** Transactions kept in flight on the SPI queue */
+#define ICE40_CMD_PIPELINE 4
+
+/** Most operations merged into one auto-increment burst */
+#define ICE40_CMD_BATCH 8
+
+/**
+ * @brief Completion callback, invoked from the engine task
+ *
+ * Keep it short: the bus is idle until it returns.
+ *
+ * @param result   ESP_OK, or the error the transaction failed with
+ * @param user_ctx Context pointer from the operation
+ */
+typedef void (*ice40_cmd_done_cb_t)(esp_err_t result, void *user_ctx);
+
+/**
+ * @brief One queued register operation
+ *
+ * The words buffer must stay valid until the operation completes; the
+ * engine stages transfers through its own DMA frames, so the buffer
+ * itself need not be DMA-capable. All completion fields are optional.
+ */
+typedef struct {
+    bool write;                ///< Direction: write to the FPGA, else read
+    uint16_t address;          ///< Starting register address
+    uint16_t count;            ///< Words to move (1..ICE40_REG_MAX_BURST)
+    uint16_t *words;           ///< Source (write) or destination (read), host byte order
+    ice40_cmd_done_cb_t done;  ///< Called on completion from the engine task
+    void *done_ctx;            ///< Context pointer passed to done
+    TaskHandle_t notify_task;  ///< Receives xTaskNotifyGive on completion
+    esp_err_t *result;         ///< Receives the result before done/notify fire
+} ice40_cmd_op_t;
+
+/**
+ * @brief Engine configuration; zeroed fields select defaults
+ */
+typedef struct {
+    size_t queue_depth;  ///< Pending operations accepted; 0 selects 16
+} ice40_cmd_config_t;
+
+/**
+ * @brief Engine counters (monotonic since init)
+ */
+typedef struct {
+    uint32_t ops;           ///< Operations completed
+    uint32_t transactions;  ///< SPI transactions issued
+    uint32_t merged;        ///< Operations coalesced into a preceding burst
+} ice40_cmd_stats_t;
+
+/** Opaque engine handle */
+typedef struct ice40_cmd ice40_cmd_t;
+
+/**
+ * @brief Create the engine and its SPI device
+ *
+ * Adds a register-protocol device on CONFIG_FPGA_CS_GPIO at
+ * CONFIG_FPGA_SPI_FREQ_COMMS with a transaction queue deep enough for
+ * pipelining, and starts the engine task. The FPGA must already be
+ * configured with a design instantiating spi_slave_reg.
+ *
+ * @param out_cmd Receives the new engine on success
+ * @param config  Engine configuration; NULL selects all defaults
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_cmd_init(ice40_cmd_t **out_cmd, const ice40_cmd_config_t *config);
+
+/**
+ * @brief Stop the engine and free resources
+ *
+ * Transactions already on the wire complete normally; operations still
+ * queued complete with ESP_ERR_INVALID_STATE.
+ *
+ * @param cmd Engine to destroy (NULL is a no-op)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_cmd_deinit(ice40_cmd_t *cmd);
+
+/**
+ * @brief Enqueue an operation (never blocks on SPI)
+ *
+ * The operation is copied; only the words buffer must outlive the
+ * call. Safe to call from any task.
+ *
+ * @param cmd     Engine handle
+ * @param op      Operation to enqueue
+ * @param timeout Ticks to wait for queue space
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the queue stayed full,
+ *         ESP_ERR_INVALID_SIZE for a bad count or NULL words
+ */
+esp_err_t ice40_cmd_submit(ice40_cmd_t *cmd, const ice40_cmd_op_t *op, TickType_t timeout);
+
+/**
+ * @brief Snapshot the engine counters
+ *
+ * @param cmd       Engine handle
+ * @param out_stats Receives the counters
+ */
+void ice40_cmd_get_stats(ice40_cmd_t *cmd, ice40_cmd_stats_t *out_stats);
+
+/** @} */
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+
+/**
+ * @defgroup ice40_frames Frame Streamer
+ * @brief Paced animation-frame delivery over queued SPI transactions
+ *
+ * Pushing animation frames with one blocking transaction per frame
+ * (the web-led send_rgb_to_fpga() pattern) tops out around 300
+ * frames/s with the producing task pinned to the bus the whole time.
+ * This streamer decouples the two: producers borrow frame buffers from
+ * a pre-allocated DMA pool, fill them, and submit; a submitter task
+ * paced by an esp_timer clocks one frame out per tick over queued
+ * transactions. When the producer runs ahead of the frame rate the
+ * oldest unsent frame is displaced (drop-oldest), so the newest frames
+ * always win and nobody blocks.
+ *
+ * Pair with an FPGA design that latches a frame on CS deassert, e.g.
+ * fpga/rtl/rgb_frame_driver.v behind a byte-wide SPI slave.
+ *
+ * @{
+ */
+
+/** @brief Frame rate used when the config asks for 0 */
+#define ICE40_FRAMES_DEFAULT_RATE_HZ 1000
+
+/** @brief Pool depth used when the config asks for 0 */
+#define ICE40_FRAMES_DEFAULT_DEPTH 8
+
+/**
+ * @brief Streamer configuration
+ */
+typedef struct {
+    size_t frame_size;  ///< Bytes per frame (e.g. channels * 3 for RGB)
+    uint32_t rate_hz;   ///< Frames clocked out per second (0 = default)
+    size_t depth;       ///< Frame buffers in the pool (0 = default)
+} ice40_frames_config_t;
+
+/**
+ * @brief Streamer counters, cumulative since init
+ */
+typedef struct {
+    uint32_t submitted;  ///< Frames handed to ice40_frames_submit()
+    uint32_t sent;       ///< Frames clocked out to the FPGA
+    uint32_t dropped;    ///< Unsent frames displaced by newer ones
+} ice40_frames_stats_t;
+
+/** Opaque streamer handle */
+typedef struct ice40_frames ice40_frames_t;
+
+/**
+ * @brief Create the streamer and start the paced submitter
+ *
+ * Adds its own device on the shared bus (hardware CS on
+ * CONFIG_FPGA_CS_GPIO so the FPGA latches each frame on CS deassert,
+ * CONFIG_FPGA_SPI_FREQ_COMMS).
+ *
+ * @param out_frames Receives the new streamer on success
+ * @param config     Streamer configuration
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_frames_init(ice40_frames_t **out_frames,
+                            const ice40_frames_config_t *config);
+
+/**
+ * @brief Stop the submitter, wait for in-flight frames, free resources
+ *
+ * @param frames Streamer to destroy (NULL is a no-op)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_frames_deinit(ice40_frames_t *frames);
+
+/**
+ * @brief Borrow a frame buffer from the pool
+ *
+ * Returns a free buffer when one is available, otherwise displaces the
+ * oldest unsent frame (counted in stats.dropped). Only blocks — up to
+ * timeout — in the corner case where every buffer is on the wire.
+ *
+ * @param frames    Streamer handle
+ * @param out_frame Receives a frame_size-byte DMA-capable buffer
+ * @param timeout   Ticks to wait if all buffers are in flight
+ * @return ESP_OK, or ESP_ERR_TIMEOUT if no buffer freed up in time
+ */
+esp_err_t ice40_frames_acquire(ice40_frames_t *frames, void **out_frame,
+                               TickType_t timeout);
+
+/**
+ * @brief Queue a filled frame for paced transmission
+ *
+ * @param frames Streamer handle
+ * @param frame  Buffer returned by ice40_frames_acquire()
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_frames_submit(ice40_frames_t *frames, void *frame);
+
+/**
+ * @brief Snapshot the streamer counters
+ *
+ * @param frames Streamer handle
+ * @param stats  Receives the cumulative counters
+ */
+void ice40_frames_get_stats(ice40_frames_t *frames, ice40_frames_stats_t *stats);
+
+/** @} */
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+
+/**
+ * @defgroup ice40_reg ICE40 Register Protocol Driver
+ * @brief Host-side driver for the spi_slave_reg.v command/address protocol
+ *
+ * Matches fpga/rtl/spi_slave_reg.v: each transaction carries an 8-bit
+ * command, a 16-bit address, 8 dummy bits for clock domain crossing, and
+ * then 16-bit data words (big-endian on the wire), all in SPI mode 3.
+ *
+ * The RTL auto-increments the address after every word, so the burst
+ * calls move N words with a single command/address header and one CS
+ * assertion instead of N separate transactions.
+ *
+ * @{
+ */
+
+/** Protocol command bytes (bit 0 selects write) */
+#define ICE40_REG_CMD_READ_MEM  0x00  ///< Burst read with auto-increment
+#define ICE40_REG_CMD_WRITE_MEM 0x01  ///< Burst write with auto-increment
+#define ICE40_REG_CMD_READ_REG  0x02  ///< Single 16-bit register read
+#define ICE40_REG_CMD_WRITE_REG 0x03  ///< Single 16-bit register write
+
+/** Largest burst (in 16-bit words) accepted by a single call */
+#define ICE40_REG_MAX_BURST 256
+
+/** Opaque handle for a register-protocol SPI device */
+typedef struct ice40_reg_dev ice40_reg_dev_t;
+
+/**
+ * @brief Register the communication SPI device for the register protocol
+ *
+ * Adds a device on the shared bus using CONFIG_FPGA_CS_GPIO (hardware
+ * CS) at CONFIG_FPGA_SPI_FREQ_COMMS. The FPGA must already be configured
+ * with a design instantiating spi_slave_reg.
+ *
+ * @param out_dev Receives the new device handle on success
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_reg_init(ice40_reg_dev_t **out_dev);
+
+/**
+ * @brief Remove the device and free its resources
+ *
+ * @param dev Device to destroy (NULL is a no-op)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_reg_deinit(ice40_reg_dev_t *dev);
+
+/**
+ * @brief Read a single 16-bit register
+ *
+ * @param dev     Device handle
+ * @param address Register address
+ * @param value   Receives the register value (host byte order)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_reg_read(ice40_reg_dev_t *dev, uint16_t address, uint16_t *value);
+
+/**
+ * @brief Write a single 16-bit register
+ *
+ * @param dev     Device handle
+ * @param address Register address
+ * @param value   Value to write (host byte order)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_reg_write(ice40_reg_dev_t *dev, uint16_t address, uint16_t value);
+
+/**
+ * @brief Read a block of words using the RTL's auto-increment
+ *
+ * One SPI transaction transfers the whole block. The data lands
+ * directly in the caller's buffer, which must be DMA-capable
+ * (heap_caps_malloc with MALLOC_CAP_DMA); words are converted to host
+ * byte order in place.
+ *
+ * @param dev     Device handle
+ * @param address Starting address
+ * @param words   DMA-capable destination, count words long
+ * @param count   Words to read (1..ICE40_REG_MAX_BURST)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_reg_read_burst(ice40_reg_dev_t *dev, uint16_t address,
+                               uint16_t *words, size_t count);
+
+/**
+ * @brief Write a block of words using the RTL's auto-increment
+ *
+ * One SPI transaction transfers the whole block (header plus payload
+ * staged in the driver's DMA frame buffer).
+ *
+ * @param dev     Device handle
+ * @param address Starting address
+ * @param words   Source words (host byte order)
+ * @param count   Words to write (1..ICE40_REG_MAX_BURST)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_reg_write_burst(ice40_reg_dev_t *dev, uint16_t address,
+                                const uint16_t *words, size_t count);
+
+/** @} */
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+
+/**
+ * @defgroup ice40_telemetry FPGA Telemetry Sampler
+ * @brief Paced status sampling from spi_slave_bulk.v designs
+ *
+ * Designs built on fpga/rtl/spi_slave_bulk.v stream counters and status
+ * words out of the FPGA, but polling them from application tasks either
+ * starves those tasks or caps the rate at whatever the HTTP server
+ * tolerates. This service runs a dedicated reader task paced by an
+ * esp_timer: each tick it clocks one fixed-size sample in over queued
+ * DMA transactions and publishes it into a lock-free single-producer
+ * ring. Consumers take either the most recent sample or a block of
+ * consecutive samples without ever touching the reader's timing.
+ *
+ * The ring is single-consumer as well: call ice40_telemetry_read() from
+ * one task only (ice40_telemetry_latest() is safe from any task). A
+ * consumer that falls more than the ring depth behind loses the oldest
+ * samples; the loss is counted, never blocked on.
+ *
+ * Do not sample while the FPGA loader is reprogramming — the loader
+ * claims the bus exclusively and the reads would stall.
+ *
+ * @{
+ */
+
+/** @brief Sampling rate used when the config asks for 0 */
+#define ICE40_TELEMETRY_DEFAULT_RATE_HZ 1000
+
+/** @brief Ring depth used when the config asks for 0 */
+#define ICE40_TELEMETRY_DEFAULT_DEPTH 256
+
+/**
+ * @brief Sampler configuration
+ */
+typedef struct {
+    size_t sample_size;  ///< Bytes clocked out of the FPGA per sample
+    uint32_t rate_hz;    ///< Samples per second (0 = default)
+    size_t depth;        ///< Ring depth in samples, rounded up to a power of two (0 = default)
+} ice40_telemetry_config_t;
+
+/** Opaque sampler handle */
+typedef struct ice40_telemetry ice40_telemetry_t;
+
+/**
+ * @brief Create the sampler and start reading
+ *
+ * Adds its own half-duplex device on the shared bus (hardware CS on
+ * CONFIG_FPGA_CS_GPIO, CONFIG_FPGA_SPI_FREQ_COMMS) and begins sampling
+ * immediately.
+ *
+ * @param out_telemetry Receives the new sampler on success
+ * @param config        Sampler configuration
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_telemetry_init(ice40_telemetry_t **out_telemetry,
+                               const ice40_telemetry_config_t *config);
+
+/**
+ * @brief Stop the reader task and free resources
+ *
+ * @param telemetry Sampler to destroy (NULL is a no-op)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_telemetry_deinit(ice40_telemetry_t *telemetry);
+
+/**
+ * @brief Copy out the most recently published sample
+ *
+ * Lock-free; never waits on the reader. Safe from any task.
+ *
+ * @param telemetry Sampler handle
+ * @param sample    Receives sample_size bytes
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND before the first sample lands
+ */
+esp_err_t ice40_telemetry_latest(ice40_telemetry_t *telemetry, void *sample);
+
+/**
+ * @brief Copy out consecutive samples from the consumer cursor
+ *
+ * Returns as soon as at least one sample is available, waiting at most
+ * timeout ticks for the first one. Samples the consumer was too slow to
+ * collect are skipped (see ice40_telemetry_dropped()).
+ *
+ * @param telemetry   Sampler handle
+ * @param samples     Receives up to max_samples * sample_size bytes
+ * @param max_samples Capacity of the destination, in samples
+ * @param timeout     Ticks to wait for data (0 = poll)
+ * @return Number of samples copied (0 on timeout)
+ */
+size_t ice40_telemetry_read(ice40_telemetry_t *telemetry, void *samples,
+                            size_t max_samples, TickType_t timeout);
+
+/**
+ * @brief Samples lost to consumer falling behind, since init
+ *
+ * @param telemetry Sampler handle
+ * @return Cumulative dropped-sample count
+ */
+uint32_t ice40_telemetry_dropped(ice40_telemetry_t *telemetry);
+
+/** @} */
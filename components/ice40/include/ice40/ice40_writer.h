@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <esp_err.h>
+
+/**
+ * @defgroup ice40_writer Coalescing Async Writer
+ * @brief Latest-value-wins decoupling between producers and SPI
+ *
+ * Interactive handlers (HTTP, WebSocket, buttons) should not stall on
+ * the SPI bus. This writer gives them a fixed-size slot to deposit the
+ * newest value into; a dedicated task flushes the most recent value to
+ * the FPGA, silently coalescing intermediate updates. Under a burst of
+ * producer events only the final value is guaranteed to reach the
+ * hardware, which is exactly the semantics a control value wants.
+ *
+ * @{
+ */
+
+/**
+ * @brief Flush callback, invoked from the writer task
+ *
+ * Performs the actual (blocking) transfer of a value snapshot.
+ *
+ * @param value    Snapshot of the most recent deposited value
+ * @param size     Value size in bytes (as given at init)
+ * @param user_ctx Context pointer given to ice40_writer_init()
+ * @return ESP_OK on success; failures are logged and the value dropped
+ */
+typedef esp_err_t (*ice40_writer_flush_cb_t)(const void *value, size_t size, void *user_ctx);
+
+/** Opaque writer handle */
+typedef struct ice40_writer ice40_writer_t;
+
+/**
+ * @brief Create a coalescing writer
+ *
+ * @param out_writer Receives the new writer on success
+ * @param value_size Fixed size of the deposited values, in bytes
+ * @param flush_cb   Callback that writes a snapshot to the hardware
+ * @param user_ctx   Context pointer passed to flush_cb
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_writer_init(ice40_writer_t **out_writer, size_t value_size,
+                            ice40_writer_flush_cb_t flush_cb, void *user_ctx);
+
+/**
+ * @brief Stop the writer task and free resources
+ *
+ * @param writer Writer to destroy (NULL is a no-op)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_writer_deinit(ice40_writer_t *writer);
+
+/**
+ * @brief Deposit a new value (never blocks on SPI)
+ *
+ * Overwrites any value not yet flushed; safe to call from any task.
+ *
+ * @param writer Writer handle
+ * @param value  value_size bytes to deposit
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ice40_writer_submit(ice40_writer_t *writer, const void *value);
+
+/** @} */
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <driver/spi_master.h>
 #include <esp_err.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
@@ -9,28 +13,49 @@
  * @brief Shared SPI bus driver for ICE40 communication
  *
  * This module manages the SPI bus used for both FPGA programming
- * and runtime communication. It provides a mutex semaphore for
- * coordinating access between multiple SPI devices (programming
- * device vs. communication device).
+ * and runtime communication.
+ *
+ * Arbitration and priorities: the ESP-IDF SPI master driver arbitrates
+ * queued transactions from all devices on the bus at transaction
+ * granularity, so no component-level lock is taken around transmits.
+ * The resulting scheme:
+ *
+ * - The FPGA loader claims the bus outright with
+ *   spi_device_acquire_bus() for the duration of a programming
+ *   sequence; every other device waits until the load completes.
+ * - Outside of loads, a latency-sensitive transaction (register write,
+ *   RGB update) waits at most for the single bulk chunk currently on
+ *   the wire, never for a whole bulk sequence. Keep bulk chunks at
+ *   CONFIG_FPGA_SPI_BUFFER_SIZE * 4 or below so that worst-case
+ *   head-of-line wait stays bounded (~0.4ms at 40MHz).
  *
  * @{
  */
 
 /**
- * @brief Semaphore for SPI bus arbitration
- *
- * Take this semaphore before any SPI transaction to ensure
- * exclusive bus access. Release it immediately after the
- * transaction completes.
+ * @brief Former global bus lock, kept as a compatibility shim
  *
- * @code
- * xSemaphoreTake(master_spi_semaphore, portMAX_DELAY);
- * spi_device_transmit(device, &transaction);
- * xSemaphoreGive(master_spi_semaphore);
- * @endcode
+ * @deprecated Transactions no longer need (and should not take) this
+ * mutex: the SPI master driver arbitrates between devices, and the
+ * loader uses spi_device_acquire_bus() for its exclusive phase. The
+ * handle is still created by master_spi_init() so out-of-tree code that
+ * locks it keeps working; in-tree callers have all been converted to
+ * plain spi_device_transmit().
  */
 extern SemaphoreHandle_t master_spi_semaphore;
 
+/**
+ * @brief Largest transfer the bus is configured to move in one
+ * transaction
+ *
+ * The SPI master driver chains DMA descriptors up to this size, so a
+ * single queued transaction can span several hardware DMA buffers.
+ * Callers that size their chunks at runtime (the FPGA loader) use this
+ * as the ceiling; the cost is a few extra descriptor entries at bus
+ * init.
+ */
+#define MASTER_SPI_MAX_TRANSFER (32 * 1024)
+
 /**
  * @brief Initialize the SPI master bus
  *
@@ -45,4 +70,132 @@ extern SemaphoreHandle_t master_spi_semaphore;
  */
 esp_err_t master_spi_init(void);
 
+/**
+ * @brief Whether the quad (4-bit) data path is wired up
+ *
+ * True when both CONFIG_FPGA_WP_GPIO and CONFIG_FPGA_HD_GPIO are
+ * assigned, giving the bus all four data lines. Note the ICE40's slave
+ * configuration port is single-bit only, so quad mode applies to runtime
+ * data transfers (spi_slave_quad.v designs), never to bitstream loading.
+ *
+ * @return true if quad transactions can be issued on this board
+ */
+bool master_spi_quad_supported(void);
+
+/**
+ * @brief Add a device for quad-output bulk reads
+ *
+ * Registers a half-duplex device on the shared bus (hardware CS on
+ * CONFIG_FPGA_CS_GPIO, CONFIG_FPGA_SPI_FREQ_COMMS) whose reads use all
+ * four data lines. Pair with a design built on fpga/rtl/spi_slave_quad.v.
+ *
+ * @param out_device Receives the device handle on success
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED without quad pins
+ */
+esp_err_t master_spi_quad_device_add(spi_device_handle_t *out_device);
+
+/**
+ * @brief Read a block over the quad data path
+ *
+ * @param device Device from master_spi_quad_device_add()
+ * @param buffer DMA-capable destination buffer
+ * @param length Bytes to read
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t master_spi_quad_read(spi_device_handle_t device, void *buffer, size_t length);
+
+/**
+ * @brief Completion callback for streamed transactions
+ *
+ * Invoked from the stream's internal task (not an ISR) once a queued
+ * buffer has finished clocking out.
+ *
+ * @param user_ctx Context pointer given to master_spi_stream_init()
+ * @param buffer   The buffer that completed (about to be recycled)
+ * @param length   Transaction length in bytes
+ */
+typedef void (*master_spi_stream_done_cb_t)(void *user_ctx, void *buffer, size_t length);
+
+/**
+ * @brief Opaque streaming context
+ *
+ * A ring of pre-allocated DMA transaction descriptors submitted with
+ * spi_device_queue_trans(), letting callers keep the bus saturated with
+ * back-to-back transfers instead of paying a blocking round trip per
+ * message. Typical cycle:
+ *
+ * @code
+ * void *buf;
+ * master_spi_stream_acquire(stream, &buf, portMAX_DELAY);
+ * // ... fill buf ...
+ * master_spi_stream_submit(stream, buf, length);
+ * @endcode
+ *
+ * Queued transactions are arbitrated by the ESP-IDF SPI master driver;
+ * do not stream while the FPGA loader is reprogramming (it claims the
+ * bus exclusively for the duration of the load).
+ */
+typedef struct master_spi_stream master_spi_stream_t;
+
+/**
+ * @brief Create a streaming context for a device
+ *
+ * The device must have been added with a queue_size of at least
+ * buffer_count.
+ *
+ * @param out_stream   Receives the new stream on success
+ * @param device       SPI device to stream to
+ * @param buffer_size  Bytes per buffer (0 = CONFIG_FPGA_SPI_BUFFER_SIZE)
+ * @param buffer_count Buffers in the ring (0 = CONFIG_FPGA_SPI_BUFFER_COUNT)
+ * @param done_cb      Optional completion callback (may be NULL)
+ * @param user_ctx     Context pointer passed to done_cb
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t master_spi_stream_init(master_spi_stream_t **out_stream,
+                                 spi_device_handle_t device,
+                                 size_t buffer_size,
+                                 size_t buffer_count,
+                                 master_spi_stream_done_cb_t done_cb,
+                                 void *user_ctx);
+
+/**
+ * @brief Wait for in-flight transactions, then free the stream
+ *
+ * @param stream Stream to destroy (NULL is a no-op)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t master_spi_stream_deinit(master_spi_stream_t *stream);
+
+/**
+ * @brief Take a free DMA buffer from the ring
+ *
+ * Blocks until a buffer is recycled by a completing transaction.
+ *
+ * @param stream     Stream to take from
+ * @param out_buffer Receives a buffer of the stream's buffer_size
+ * @param timeout    Ticks to wait (portMAX_DELAY to block indefinitely)
+ * @return ESP_OK, or ESP_ERR_TIMEOUT if no buffer freed up in time
+ */
+esp_err_t master_spi_stream_acquire(master_spi_stream_t *stream, void **out_buffer,
+                                    TickType_t timeout);
+
+/**
+ * @brief Queue an acquired buffer for transmission
+ *
+ * @param stream Stream the buffer was acquired from
+ * @param buffer Buffer returned by master_spi_stream_acquire()
+ * @param length Bytes to transmit (at most the stream's buffer_size)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t master_spi_stream_submit(master_spi_stream_t *stream, void *buffer, size_t length);
+
+/**
+ * @brief Block until every queued transaction has completed
+ *
+ * @param stream  Stream to drain
+ * @param timeout Ticks to wait for the ring to go idle
+ * @return ESP_OK, or ESP_ERR_TIMEOUT if transactions remain in flight
+ */
+esp_err_t master_spi_stream_drain(master_spi_stream_t *stream, TickType_t timeout);
+
 /** @} */
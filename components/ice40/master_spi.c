@@ -1,9 +1,23 @@
 #include "ice40/master_spi.h"
 #include <driver/spi_master.h>
+#include <esp_heap_caps.h>
 #include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// How often the reaper task wakes to check for stream shutdown while no
+// transactions are completing
+#define STREAM_REAPER_POLL_MS 100
 
 static const char *TAG = "ice40_spi";
 
+// Compatibility shim only: nothing in the tree locks this anymore. Bus
+// access is arbitrated per device by the ESP-IDF SPI master driver (see
+// the priority scheme in master_spi.h).
 SemaphoreHandle_t master_spi_semaphore = NULL;
 
 esp_err_t master_spi_init(void)
@@ -27,7 +41,7 @@ esp_err_t master_spi_init(void)
         .sclk_io_num = CONFIG_FPGA_SCLK_GPIO,
         .quadwp_io_num = CONFIG_FPGA_WP_GPIO,
         .quadhd_io_num = CONFIG_FPGA_HD_GPIO,
-        .max_transfer_sz = CONFIG_FPGA_SPI_BUFFER_SIZE * 4,
+        .max_transfer_sz = MASTER_SPI_MAX_TRANSFER,
         .flags = SPICOMMON_BUSFLAG_MASTER | SPICOMMON_BUSFLAG_GPIO_PINS,
     };
 
@@ -40,3 +54,246 @@ esp_err_t master_spi_init(void)
     ESP_LOGI(TAG, "SPI bus initialized");
     return ESP_OK;
 }
+
+// Streaming API: a ring of pre-allocated DMA transaction descriptors.
+// Callers acquire a buffer, fill it, and submit; an internal reaper task
+// retires completed transactions, fires the completion callback, and
+// recycles the buffer into the ring.
+
+typedef struct {
+    spi_transaction_t trans;  // Must stay first: completed transactions
+                              // are cast back to their slot
+    uint8_t *buffer;
+} stream_slot_t;
+
+struct master_spi_stream {
+    spi_device_handle_t device;
+    size_t buffer_size;
+    size_t buffer_count;
+    master_spi_stream_done_cb_t done_cb;
+    void *user_ctx;
+    stream_slot_t *slots;
+    uint8_t *buffers;
+    QueueHandle_t free_slots;
+    SemaphoreHandle_t reaper_exited;
+    volatile bool shutdown;
+};
+
+static void stream_reaper_task(void *arg)
+{
+    master_spi_stream_t *stream = (master_spi_stream_t *)arg;
+
+    while (!stream->shutdown) {
+        spi_transaction_t *trans;
+        esp_err_t ret = spi_device_get_trans_result(stream->device, &trans,
+                                                    pdMS_TO_TICKS(STREAM_REAPER_POLL_MS));
+        if (ret == ESP_ERR_TIMEOUT) {
+            continue;
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Stream transaction failed: %s", esp_err_to_name(ret));
+            continue;
+        }
+
+        stream_slot_t *slot = (stream_slot_t *)trans;
+
+        if (stream->done_cb != NULL) {
+            stream->done_cb(stream->user_ctx, slot->buffer, trans->length / 8);
+        }
+
+        xQueueSend(stream->free_slots, &slot, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(stream->reaper_exited);
+    vTaskDelete(NULL);
+}
+
+esp_err_t master_spi_stream_init(master_spi_stream_t **out_stream,
+                                 spi_device_handle_t device,
+                                 size_t buffer_size,
+                                 size_t buffer_count,
+                                 master_spi_stream_done_cb_t done_cb,
+                                 void *user_ctx)
+{
+    if (buffer_size == 0) {
+        buffer_size = CONFIG_FPGA_SPI_BUFFER_SIZE;
+    }
+    if (buffer_count == 0) {
+        buffer_count = CONFIG_FPGA_SPI_BUFFER_COUNT;
+    }
+
+    master_spi_stream_t *stream = calloc(1, sizeof(master_spi_stream_t));
+    if (stream == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    stream->device = device;
+    stream->buffer_size = buffer_size;
+    stream->buffer_count = buffer_count;
+    stream->done_cb = done_cb;
+    stream->user_ctx = user_ctx;
+
+    stream->slots = calloc(buffer_count, sizeof(stream_slot_t));
+    stream->buffers = heap_caps_malloc(buffer_size * buffer_count, MALLOC_CAP_DMA);
+    stream->free_slots = xQueueCreate(buffer_count, sizeof(stream_slot_t *));
+    stream->reaper_exited = xSemaphoreCreateBinary();
+
+    if (stream->slots == NULL || stream->buffers == NULL ||
+        stream->free_slots == NULL || stream->reaper_exited == NULL) {
+        goto fail;
+    }
+
+    for (size_t i = 0; i < buffer_count; i++) {
+        stream_slot_t *slot = &stream->slots[i];
+        slot->buffer = stream->buffers + (i * buffer_size);
+        xQueueSend(stream->free_slots, &slot, 0);
+    }
+
+    if (xTaskCreate(stream_reaper_task, "spi_stream", 3072, stream, 10, NULL) != pdPASS) {
+        goto fail;
+    }
+
+    *out_stream = stream;
+    return ESP_OK;
+
+fail:
+    if (stream->reaper_exited != NULL) {
+        vSemaphoreDelete(stream->reaper_exited);
+    }
+    if (stream->free_slots != NULL) {
+        vQueueDelete(stream->free_slots);
+    }
+    heap_caps_free(stream->buffers);
+    free(stream->slots);
+    free(stream);
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t master_spi_stream_acquire(master_spi_stream_t *stream, void **out_buffer,
+                                    TickType_t timeout)
+{
+    stream_slot_t *slot;
+    if (xQueueReceive(stream->free_slots, &slot, timeout) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    *out_buffer = slot->buffer;
+    return ESP_OK;
+}
+
+esp_err_t master_spi_stream_submit(master_spi_stream_t *stream, void *buffer, size_t length)
+{
+    if (length == 0 || length > stream->buffer_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ptrdiff_t offset = (uint8_t *)buffer - stream->buffers;
+    if (offset < 0 || (size_t)offset >= stream->buffer_size * stream->buffer_count ||
+        offset % stream->buffer_size != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    stream_slot_t *slot = &stream->slots[offset / stream->buffer_size];
+
+    memset(&slot->trans, 0, sizeof(spi_transaction_t));
+    slot->trans.length = length * 8;
+    slot->trans.tx_buffer = slot->buffer;
+
+    esp_err_t ret = spi_device_queue_trans(stream->device, &slot->trans, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        // Don't leak the slot if the driver rejected the transaction
+        xQueueSend(stream->free_slots, &slot, portMAX_DELAY);
+    }
+
+    return ret;
+}
+
+esp_err_t master_spi_stream_drain(master_spi_stream_t *stream, TickType_t timeout)
+{
+    // Once we hold every slot, nothing can be in flight
+    stream_slot_t **claimed = calloc(stream->buffer_count, sizeof(stream_slot_t *));
+    if (claimed == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    TickType_t deadline = xTaskGetTickCount() + timeout;
+    size_t held = 0;
+    esp_err_t ret = ESP_OK;
+
+    while (held < stream->buffer_count) {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = (timeout == portMAX_DELAY) ? portMAX_DELAY
+                        : (now < deadline) ? (deadline - now) : 0;
+        if (xQueueReceive(stream->free_slots, &claimed[held], wait) != pdTRUE) {
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        }
+        held++;
+    }
+
+    for (size_t i = 0; i < held; i++) {
+        xQueueSend(stream->free_slots, &claimed[i], 0);
+    }
+
+    free(claimed);
+    return ret;
+}
+
+esp_err_t master_spi_stream_deinit(master_spi_stream_t *stream)
+{
+    if (stream == NULL) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = master_spi_stream_drain(stream, portMAX_DELAY);
+
+    stream->shutdown = true;
+    xSemaphoreTake(stream->reaper_exited, portMAX_DELAY);
+
+    vSemaphoreDelete(stream->reaper_exited);
+    vQueueDelete(stream->free_slots);
+    heap_caps_free(stream->buffers);
+    free(stream->slots);
+    free(stream);
+
+    return ret;
+}
+
+// Quad (4-bit) data path. The bus config already routes WP/HD when the
+// board wires them; these helpers issue transactions whose data phase
+// uses all four lines against spi_slave_quad.v designs. The ICE40 slave
+// configuration port is single-bit, so the loader never uses this path.
+
+bool master_spi_quad_supported(void)
+{
+    return CONFIG_FPGA_WP_GPIO >= 0 && CONFIG_FPGA_HD_GPIO >= 0;
+}
+
+esp_err_t master_spi_quad_device_add(spi_device_handle_t *out_device)
+{
+    if (!master_spi_quad_supported()) {
+        ESP_LOGE(TAG, "Quad data path needs WP and HD GPIOs assigned");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = CONFIG_FPGA_SPI_FREQ_COMMS * 1000000,
+        .mode = 0,  // spi_slave_quad uses SPI Mode 0
+        .spics_io_num = CONFIG_FPGA_CS_GPIO,
+        .queue_size = CONFIG_FPGA_SPI_BUFFER_COUNT,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+    };
+
+    return spi_bus_add_device(FSPI_HOST, &devcfg, out_device);
+}
+
+esp_err_t master_spi_quad_read(spi_device_handle_t device, void *buffer, size_t length)
+{
+    spi_transaction_t trans = {
+        .flags = SPI_TRANS_MODE_QIO,
+        .rxlength = length * 8,
+        .rx_buffer = buffer,
+    };
+
+    return spi_device_transmit(device, &trans);
+}
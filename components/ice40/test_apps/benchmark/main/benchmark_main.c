@@ -0,0 +1,289 @@
+/**
+ * ICE40 component throughput benchmark
+ *
+ * Run on a real board (CI hardware rack or bench) to get regression
+ * numbers for the loader and the runtime SPI paths. Results print as
+ * machine-parsable lines:
+ *
+ *   BENCH,<name>,key=value,key=value,...
+ *
+ * Coverage:
+ *   - Bitstream load throughput at CONFIG_FPGA_SPI_FREQ_PROGRAMMING
+ *     and LOADER_BUFFER_SIZE (pseudo-bitstream; CDONE is expected to
+ *     time out unless a real image is flashed, the cdone=0 field and
+ *     the fixed 100ms timeout are reported so the transfer rate can be
+ *     derived either way)
+ *   - Small-transaction round-trip latency against spi_slave_reg.v
+ *     (single-word and burst reads)
+ *   - Pipelined command engine op rate against the same register design,
+ *     for comparison with the blocking single-word numbers
+ *   - Frame streamer throughput against rgb_frame_driver.v designs
+ *   - Sustained read throughput against spi_slave_bulk.v
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "driver/spi_master.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "ice40.h"
+
+static const char *TAG = "ice40_bench";
+
+// Size of a typical UP5K bitstream
+#define PSEUDO_BITSTREAM_SIZE (104 * 1024)
+
+#define LOAD_ITERATIONS 3
+#define REG_LATENCY_ITERATIONS 1000
+#define BULK_READ_TOTAL (256 * 1024)
+#define BULK_CHUNK_SIZE (CONFIG_FPGA_SPI_BUFFER_SIZE * 4)
+#define CMD_BENCH_OPS 1000
+#define FRAME_CHANNELS 4
+#define FRAME_RATE_HZ 4000
+#define FRAME_BENCH_MS 2000
+
+static void bench_load(void)
+{
+    uint8_t *bitstream = heap_caps_malloc(PSEUDO_BITSTREAM_SIZE, MALLOC_CAP_8BIT);
+    if (bitstream == NULL) {
+        ESP_LOGE(TAG, "No memory for pseudo-bitstream");
+        return;
+    }
+    for (size_t i = 0; i < PSEUDO_BITSTREAM_SIZE; i++) {
+        bitstream[i] = (uint8_t)(i * 7);
+    }
+
+    fpga_bin_t bin = {
+        .start = bitstream,
+        .end = bitstream + PSEUDO_BITSTREAM_SIZE,
+    };
+
+    fpga_loader_ctx_t *ctx;
+    esp_err_t ret = fpga_loader_ctx_init(&ctx);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Loader ctx init failed: %s", esp_err_to_name(ret));
+        heap_caps_free(bitstream);
+        return;
+    }
+
+    for (int i = 0; i < LOAD_ITERATIONS; i++) {
+        int64_t start = esp_timer_get_time();
+        ret = fpga_loader_ctx_load_from_rom(ctx, &bin);
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        printf("BENCH,load,iter=%d,freq_mhz=%d,buffer=%d,bytes=%d,us=%lld,mbps=%.2f,cdone=%d\n",
+               i, CONFIG_FPGA_SPI_FREQ_PROGRAMMING, CONFIG_FPGA_SPI_BUFFER_SIZE * 4,
+               PSEUDO_BITSTREAM_SIZE, elapsed,
+               (double)PSEUDO_BITSTREAM_SIZE / (double)elapsed,
+               ret == ESP_OK);
+    }
+
+    fpga_loader_ctx_deinit(ctx);
+    heap_caps_free(bitstream);
+}
+
+static void bench_reg_latency(void)
+{
+    ice40_reg_dev_t *dev;
+    esp_err_t ret = ice40_reg_init(&dev);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Register device init failed: %s", esp_err_to_name(ret));
+        return;
+    }
+
+    // Single-word round trips
+    uint16_t value;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < REG_LATENCY_ITERATIONS; i++) {
+        ice40_reg_read(dev, 0, &value);
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    printf("BENCH,reg_single,iters=%d,us=%lld,us_per_op=%.2f,ops_per_s=%.0f\n",
+           REG_LATENCY_ITERATIONS, elapsed,
+           (double)elapsed / REG_LATENCY_ITERATIONS,
+           REG_LATENCY_ITERATIONS * 1e6 / (double)elapsed);
+
+    // Burst reads at telemetry-typical sizes
+    uint16_t *words = heap_caps_malloc(ICE40_REG_MAX_BURST * 2, MALLOC_CAP_DMA);
+    if (words != NULL) {
+        const size_t counts[] = {64, 256};
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            const int iters = 100;
+            start = esp_timer_get_time();
+            for (int i = 0; i < iters; i++) {
+                ice40_reg_read_burst(dev, 0, words, counts[c]);
+            }
+            elapsed = esp_timer_get_time() - start;
+            printf("BENCH,reg_burst,words=%u,iters=%d,us=%lld,us_per_op=%.2f,words_per_s=%.0f\n",
+                   (unsigned)counts[c], iters, elapsed, (double)elapsed / iters,
+                   (double)counts[c] * iters * 1e6 / (double)elapsed);
+        }
+        heap_caps_free(words);
+    }
+
+    ice40_reg_deinit(dev);
+}
+
+static void bench_cmd(void)
+{
+    ice40_cmd_t *cmd;
+    esp_err_t ret = ice40_cmd_init(&cmd, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Command engine init failed: %s", esp_err_to_name(ret));
+        return;
+    }
+
+    // Same single-word read as bench_reg_single, but submitted async so
+    // the engine pipelines them; one destination per in-flight slot.
+    // Completions are in order, so notifying on the last op waits for all.
+    static uint16_t values[ICE40_CMD_PIPELINE];
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < CMD_BENCH_OPS; i++) {
+        ice40_cmd_op_t op = {
+            .address = 0,
+            .count = 1,
+            .words = &values[i % ICE40_CMD_PIPELINE],
+        };
+        if (i == CMD_BENCH_OPS - 1) {
+            op.notify_task = xTaskGetCurrentTaskHandle();
+        }
+        ice40_cmd_submit(cmd, &op, portMAX_DELAY);
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    ice40_cmd_stats_t stats;
+    ice40_cmd_get_stats(cmd, &stats);
+
+    printf("BENCH,cmd_pipelined,ops=%d,transactions=%u,merged=%u,us=%lld,us_per_op=%.2f,ops_per_s=%.0f\n",
+           CMD_BENCH_OPS, stats.transactions, stats.merged, elapsed,
+           (double)elapsed / CMD_BENCH_OPS,
+           CMD_BENCH_OPS * 1e6 / (double)elapsed);
+
+    ice40_cmd_deinit(cmd);
+}
+
+static void bench_frames(void)
+{
+    ice40_frames_config_t config = {
+        .frame_size = FRAME_CHANNELS * 3,
+        .rate_hz = FRAME_RATE_HZ,
+    };
+
+    ice40_frames_t *frames;
+    esp_err_t ret = ice40_frames_init(&frames, &config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Frame streamer init failed: %s", esp_err_to_name(ret));
+        return;
+    }
+
+    // Produce as fast as acquire allows; drop-oldest keeps this from
+    // ever blocking for more than a buffer recycle
+    uint32_t produced = 0;
+    int64_t start = esp_timer_get_time();
+    while (esp_timer_get_time() - start < FRAME_BENCH_MS * 1000) {
+        void *frame;
+        if (ice40_frames_acquire(frames, &frame, pdMS_TO_TICKS(10)) != ESP_OK) {
+            continue;
+        }
+        memset(frame, (uint8_t)produced, config.frame_size);
+        ice40_frames_submit(frames, frame);
+        produced++;
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    ice40_frames_stats_t stats;
+    ice40_frames_get_stats(frames, &stats);
+
+    printf("BENCH,frames,rate_hz=%d,size=%d,produced=%u,sent=%u,dropped=%u,us=%lld,fps=%.0f\n",
+           FRAME_RATE_HZ, FRAME_CHANNELS * 3, produced, stats.sent, stats.dropped,
+           elapsed, (double)stats.sent * 1e6 / (double)elapsed);
+
+    ice40_frames_deinit(frames);
+}
+
+static void bench_bulk_throughput(void)
+{
+    // Same device setup the examples use for spi_slave_bulk designs
+    spi_device_interface_config_t devcfg = {
+        .clock_speed_hz = CONFIG_FPGA_SPI_FREQ_COMMS * 1000000,
+        .mode = 0,
+        .spics_io_num = CONFIG_FPGA_CS_GPIO,
+        .queue_size = CONFIG_FPGA_SPI_BUFFER_COUNT,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+    };
+
+    spi_device_handle_t device;
+    esp_err_t ret = spi_bus_add_device(FSPI_HOST, &devcfg, &device);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Bulk device add failed: %s", esp_err_to_name(ret));
+        return;
+    }
+
+    uint8_t *buffer = heap_caps_malloc(BULK_CHUNK_SIZE, MALLOC_CAP_DMA);
+    if (buffer == NULL) {
+        ESP_LOGE(TAG, "No memory for bulk buffer");
+        spi_bus_remove_device(device);
+        return;
+    }
+
+    size_t total = 0;
+    int64_t start = esp_timer_get_time();
+    while (total < BULK_READ_TOTAL) {
+        spi_transaction_t trans = {
+            .rxlength = BULK_CHUNK_SIZE * 8,
+            .rx_buffer = buffer,
+        };
+
+        ret = spi_device_transmit(device, &trans);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Bulk read failed: %s", esp_err_to_name(ret));
+            break;
+        }
+        total += BULK_CHUNK_SIZE;
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    printf("BENCH,bulk_read,freq_mhz=%d,chunk=%d,bytes=%d,us=%lld,mbps=%.2f\n",
+           CONFIG_FPGA_SPI_FREQ_COMMS, BULK_CHUNK_SIZE, total, elapsed,
+           (double)total / (double)elapsed);
+
+    heap_caps_free(buffer);
+    spi_bus_remove_device(device);
+}
+
+void app_main(void)
+{
+    ESP_LOGI(TAG, "ICE40 benchmark starting");
+
+    esp_err_t ret = master_spi_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SPI init failed: %s", esp_err_to_name(ret));
+        return;
+    }
+
+    ret = fpga_loader_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "FPGA loader init failed: %s", esp_err_to_name(ret));
+        return;
+    }
+
+    bench_load();
+    bench_reg_latency();
+    bench_cmd();
+    bench_frames();
+    bench_bulk_throughput();
+
+    printf("BENCH,done\n");
+    ESP_LOGI(TAG, "Benchmark complete");
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(10000));
+    }
+}
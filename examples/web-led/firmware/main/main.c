@@ -35,6 +35,9 @@ static spi_device_handle_t fpga_spi_device = NULL;
 // Current RGB values
 static uint8_t current_r = 0, current_g = 0, current_b = 0;
 
+// Coalescing writer decoupling HTTP handlers from SPI latency
+static ice40_writer_t *rgb_writer = NULL;
+
 // WiFi AP configuration
 #define WIFI_SSID "FPGA-LED"
 #define WIFI_PASS "colorwheel"
@@ -67,16 +70,28 @@ static const char *INDEX_HTML =
 "  <script>\n"
 "    const picker = document.getElementById('colorPicker');\n"
 "    const display = document.getElementById('colorValue');\n"
+"    let ws = null;\n"
+"    function connect() {\n"
+"      ws = new WebSocket('ws://' + location.host + '/ws');\n"
+"      ws.binaryType = 'arraybuffer';\n"
+"      ws.onclose = () => setTimeout(connect, 1000);\n"
+"    }\n"
+"    connect();\n"
 "    let timeout = null;\n"
 "    picker.addEventListener('input', function() {\n"
 "      display.textContent = this.value;\n"
 "      display.style.color = this.value;\n"
+"      const hex = this.value.substring(1);\n"
+"      const r = parseInt(hex.substring(0,2), 16);\n"
+"      const g = parseInt(hex.substring(2,4), 16);\n"
+"      const b = parseInt(hex.substring(4,6), 16);\n"
+"      if (ws && ws.readyState === WebSocket.OPEN) {\n"
+"        ws.send(new Uint8Array([r, g, b]));\n"
+"        return;\n"
+"      }\n"
+"      // Fallback for clients without the socket (keeps old behavior)\n"
 "      clearTimeout(timeout);\n"
 "      timeout = setTimeout(() => {\n"
-"        const hex = this.value.substring(1);\n"
-"        const r = parseInt(hex.substring(0,2), 16);\n"
-"        const g = parseInt(hex.substring(2,4), 16);\n"
-"        const b = parseInt(hex.substring(4,6), 16);\n"
 "        fetch('/set?r=' + r + '&g=' + g + '&b=' + b);\n"
 "      }, 50);\n"
 "    });\n"
@@ -98,17 +113,22 @@ static esp_err_t send_rgb_to_fpga(uint8_t r, uint8_t g, uint8_t b)
         .tx_buffer = data,
     };
 
-    xSemaphoreTake(master_spi_semaphore, portMAX_DELAY);
     esp_err_t ret = spi_device_transmit(fpga_spi_device, &trans);
-    xSemaphoreGive(master_spi_semaphore);
 
     if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "Sent RGB(%d, %d, %d) to FPGA", r, g, b);
+        ESP_LOGD(TAG, "Sent RGB(%d, %d, %d) to FPGA", r, g, b);
     }
 
     return ret;
 }
 
+// Flush callback for the coalescing writer (runs in the writer task)
+static esp_err_t rgb_flush(const void *value, size_t size, void *user_ctx)
+{
+    const uint8_t *rgb = (const uint8_t *)value;
+    return send_rgb_to_fpga(rgb[0], rgb[1], rgb[2]);
+}
+
 // HTTP handler for index page
 static esp_err_t index_handler(httpd_req_t *req)
 {
@@ -146,13 +166,52 @@ static esp_err_t set_handler(httpd_req_t *req)
     current_g = g;
     current_b = b;
 
-    send_rgb_to_fpga(r, g, b);
+    // Deposit and return immediately: the writer task flushes the most
+    // recent value, so a burst of slider events never backs up the
+    // HTTP handler queue
+    uint8_t rgb[3] = {r, g, b};
+    ice40_writer_submit(rgb_writer, rgb);
 
     httpd_resp_set_type(req, "text/plain");
     httpd_resp_send(req, "OK", 2);
     return ESP_OK;
 }
 
+// WebSocket handler: each message is a compact 3-byte binary frame
+// [R, G, B] deposited straight into the coalescing writer — no TCP
+// setup, HTTP parse, or query-string handling per update
+static esp_err_t ws_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET) {
+        ESP_LOGI(TAG, "WebSocket client connected");
+        return ESP_OK;  // Handshake already completed by the server
+    }
+
+    httpd_ws_frame_t frame = {0};
+    esp_err_t ret = httpd_ws_recv_frame(req, &frame, 0);  // Length only
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    uint8_t payload[8];
+    if (frame.len == 0 || frame.len > sizeof(payload)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    frame.payload = payload;
+    ret = httpd_ws_recv_frame(req, &frame, frame.len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (frame.type == HTTPD_WS_TYPE_BINARY && frame.len >= 3) {
+        current_r = payload[0];
+        current_g = payload[1];
+        current_b = payload[2];
+        ice40_writer_submit(rgb_writer, payload);
+    }
+    return ESP_OK;
+}
+
 static httpd_handle_t start_webserver(void)
 {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
@@ -173,6 +232,14 @@ static httpd_handle_t start_webserver(void)
         };
         httpd_register_uri_handler(server, &set_uri);
 
+        httpd_uri_t ws_uri = {
+            .uri = "/ws",
+            .method = HTTP_GET,
+            .handler = ws_handler,
+            .is_websocket = true,
+        };
+        httpd_register_uri_handler(server, &ws_uri);
+
         ESP_LOGI(TAG, "HTTP server started");
     }
 
@@ -283,6 +350,13 @@ void app_main(void)
         return;
     }
 
+    // Start the coalescing RGB writer
+    ret = ice40_writer_init(&rgb_writer, 3, rgb_flush, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start RGB writer: %s", esp_err_to_name(ret));
+        return;
+    }
+
     // Set initial color (off)
     send_rgb_to_fpga(0, 0, 0);
 
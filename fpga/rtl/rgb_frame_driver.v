@@ -0,0 +1,72 @@
+/**
+ * Multi-Channel RGB Frame Driver for ICE40
+ *
+ * Consumes byte-serial animation frames of CHANNELS * 3 PWM levels
+ * (R, G, B per channel, channel 0 first) and drives one PWM output per
+ * color. Pair it with a byte-wide SPI slave: bytes accumulate in a
+ * shadow buffer and the whole frame is latched atomically on
+ * i_frame_latch (typically CS deassert), so a partially transferred
+ * frame never reaches the LEDs. Bytes past the frame length are
+ * ignored; a short frame leaves the missing channels unchanged.
+ *
+ * Channel 0 is intended for the internal LED via SB_RGBA_DRV (see
+ * rgb_led_driver.v); further channels drive external LEDs from
+ * ordinary pins.
+ *
+ * Parameters:
+ *   CHANNELS - RGB channels per frame
+ *
+ * Inputs:
+ *   i_byte, i_byte_valid - received frame bytes, one strobe per byte
+ *   i_frame_latch        - apply the shadow buffer and reset the write
+ *                          pointer
+ *
+ * Outputs:
+ *   o_r_pwm, o_g_pwm, o_b_pwm - per-channel PWM waveforms
+ */
+module rgb_frame_driver #(
+    parameter CHANNELS = 4
+) (
+    input wire i_clk,
+    input wire [7:0] i_byte,
+    input wire i_byte_valid,
+    input wire i_frame_latch,
+    output wire [CHANNELS-1:0] o_r_pwm,
+    output wire [CHANNELS-1:0] o_g_pwm,
+    output wire [CHANNELS-1:0] o_b_pwm
+);
+
+    localparam FRAME_BYTES = CHANNELS * 3;
+
+    reg [7:0] shadow [0:FRAME_BYTES-1];  // Frame being received
+    reg [7:0] levels [0:FRAME_BYTES-1];  // Frame driving the PWMs
+    reg [7:0] wr_ptr = 0;
+
+    integer i;
+    always @(posedge i_clk) begin
+        if (i_frame_latch) begin
+            for (i = 0; i < FRAME_BYTES; i = i + 1)
+                if (i < wr_ptr)
+                    levels[i] <= shadow[i];
+            wr_ptr <= 0;
+        end else if (i_byte_valid && wr_ptr < FRAME_BYTES) begin
+            shadow[wr_ptr] <= i_byte;
+            wr_ptr <= wr_ptr + 1;
+        end
+    end
+
+    // Shared PWM counter; one comparator per color
+    reg [7:0] pwm_counter = 0;
+    always @(posedge i_clk)
+        pwm_counter <= pwm_counter + 1;
+
+    genvar ch;
+    generate
+        for (ch = 0; ch < CHANNELS; ch = ch + 1) begin : channel
+            assign o_r_pwm[ch] = (pwm_counter < levels[ch * 3 + 0]);
+            assign o_g_pwm[ch] = (pwm_counter < levels[ch * 3 + 1]);
+            assign o_b_pwm[ch] = (pwm_counter < levels[ch * 3 + 2]);
+        end
+    endgenerate
+
+endmodule
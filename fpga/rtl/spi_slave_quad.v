@@ -0,0 +1,67 @@
+/**
+ * SPI Slave - Quad Bulk Status Read
+ *
+ * Quad-output variant of spi_slave_bulk: streams a fixed-width status
+ * register out four bits per clock on io[3:0], for a straight 4x on the
+ * same SCK frequency. Operates entirely in the SPI clock domain.
+ *
+ * Protocol:
+ *   - SPI Mode 0 (CPOL=0, CPHA=0)
+ *   - High nibble of each byte first, matching standard quad-output
+ *     flash framing: IO0 carries the nibble LSB, IO3 the MSB
+ *   - Master issues the read with a 4-bit data phase
+ *     (spi_transaction_t flag SPI_TRANS_MODE_QIO, see
+ *     master_spi_quad_read() in the ice40 component)
+ *   - Data latched at CS falling edge
+ *
+ * Pin mapping on the ESP32-S2 FSPI bus:
+ *   o_io[0] -> MOSI (IO0)    o_io[2] -> WP (IO2)
+ *   o_io[1] -> MISO (IO1)    o_io[3] -> HD (IO3)
+ *
+ * Parameters:
+ *   DATA_WIDTH - Total bits to send (must be multiple of 8)
+ *
+ * Example instantiation for 10-byte status:
+ *   spi_slave_quad #(.DATA_WIDTH(80)) spi_inst (
+ *       .i_cs(FSPI_CS),
+ *       .i_sck(FSPI_CLK),
+ *       .o_io({FSPI_HD, FSPI_WP, FSPI_MISO, FSPI_MOSI}),
+ *       .i_data({8'h00, status, lock_count, cycles})
+ *   );
+ */
+module spi_slave_quad #(
+    parameter DATA_WIDTH = 80
+) (
+    // SPI interface
+    input wire i_cs,                        // Chip select (active low)
+    input wire i_sck,                       // SPI clock
+    output reg [3:0] o_io,                  // Quad data lines IO0-IO3
+
+    // Data input (directly from system clock domain - async)
+    input wire [DATA_WIDTH-1:0] i_data
+);
+
+    reg [DATA_WIDTH-1:0] shift_reg;
+    reg [$clog2(DATA_WIDTH)-1:0] bit_counter;
+
+    // Latch data at start of transaction (CS falling edge)
+    always @(negedge i_cs) begin
+        // Pre-shift by one nibble for SPI Mode 0 timing compensation
+        // (we output on falling edge, master samples on rising edge)
+        shift_reg <= i_data << 4;
+    end
+
+    // Shift out one nibble on SCK falling edge
+    always @(negedge i_sck or posedge i_cs) begin
+        if (i_cs) begin
+            // CS high (idle) - release the data lines low, reset counter
+            o_io <= 4'b0000;
+            bit_counter <= DATA_WIDTH - 1;
+        end else begin
+            // CS low (active) - present the next nibble, MSB on IO3
+            o_io <= shift_reg[bit_counter -: 4];
+            bit_counter <= (bit_counter < 4) ? DATA_WIDTH - 1 : bit_counter - 4;
+        end
+    end
+
+endmodule
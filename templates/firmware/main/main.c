@@ -26,6 +26,7 @@ void app_main(void)
     ESP_LOGI(TAG, "{{PROJECT_NAME}} starting");
 
     // Initialize SPI bus
+    ice40_boot_stage_begin("spi_init");
     esp_err_t ret = master_spi_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "SPI init failed: %s", esp_err_to_name(ret));
@@ -33,6 +34,7 @@ void app_main(void)
     }
 
     // Initialize FPGA loader
+    ice40_boot_stage_begin("loader_init");
     ret = fpga_loader_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "FPGA loader init failed: %s", esp_err_to_name(ret));
@@ -40,11 +42,17 @@ void app_main(void)
     }
 
     // Load FPGA bitstream
+    ice40_boot_stage_begin("fpga_load");
     ret = fpga_loader_load_from_rom(&fpga_image);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "FPGA load failed: %s", esp_err_to_name(ret));
         return;
     }
+    ice40_boot_stage_end();
+
+    // One-line BOOT summary; keep it when adding stages around your own
+    // bring-up so slow boots stay diagnosable across firmware variants
+    ice40_boot_report();
 
     ESP_LOGI(TAG, "FPGA loaded successfully");
 
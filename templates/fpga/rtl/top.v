@@ -4,7 +4,7 @@
  *
  * This template provides:
  *   - 48MHz internal oscillator
- *   - SPI slave for ESP32 communication
+ *   - SPI register slave with the standard identity register
  *   - RGB LED status indicator
  */
 module top (
@@ -41,34 +41,54 @@ module top (
     );
 
     // ==========================================================================
-    // Status Registers (exposed via SPI)
+    // Register Map (exposed via SPI, spi_slave_reg.v protocol)
     // ==========================================================================
-    // Example: 10-byte status packet
-    // Byte 0: 0x00 (padding)
-    // Byte 1: status flags
-    // Bytes 2-5: counter value (big-endian)
-    // Bytes 6-9: reserved
+    // Address 0 is the standard identity register: the loader's
+    // fpga_loader_verify() reads it back after configuration to confirm
+    // the expected design is actually running. Keep DEVICE_ID in sync
+    // with the --device-id the bitstream is packed with (affogato pack).
+    //
+    //   0x0000: DEVICE_ID
+    //   0x0001: status flags
+    //   0x0002: counter[31:16]
+    //   0x0003: counter[15:0]
+
+    localparam DEVICE_ID = 16'h0001;
 
     reg [7:0] status_flags;
     reg [31:0] counter;
 
-    wire [79:0] spi_data = {
-        8'h00,              // Padding byte
-        status_flags,       // Status flags
-        counter,            // 32-bit counter
-        32'h00000000        // Reserved
-    };
+    wire [7:0] command;
+    wire [15:0] address;
+    wire [15:0] write_data;
+    wire transaction_strobe;
+    reg [15:0] read_data;
+
+    always @(*) begin
+        case (address)
+            16'h0000: read_data = DEVICE_ID;
+            16'h0001: read_data = {8'h00, status_flags};
+            16'h0002: read_data = counter[31:16];
+            16'h0003: read_data = counter[15:0];
+            default:  read_data = 16'h0000;
+        endcase
+    end
 
     // ==========================================================================
-    // SPI Slave (bulk status read)
+    // SPI Slave (register protocol)
     // ==========================================================================
-    spi_slave_bulk #(
-        .DATA_WIDTH(80)
-    ) spi_inst (
+    spi_slave_reg spi_inst (
+        .i_clk(clk),
+        .i_rst(1'b0),
         .i_cs(FSPI_CS),
         .i_sck(FSPI_CLK),
+        .i_mosi(FSPI_MOSI),
         .o_miso(FSPI_MISO),
-        .i_data(spi_data)
+        .o_command(command),
+        .o_address(address),
+        .o_write_data(write_data),
+        .i_read_data(read_data),
+        .o_transaction_strobe(transaction_strobe)
     );
 
     // ==========================================================================